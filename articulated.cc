@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/SignalStats.hh>
+#include <ignition/math/Vector3.hh>
+
+#include "gazebo/physics/physics.hh"
+#include "articulated.hh"
+#include "step_timer.hh"
+#include "world_builder.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+// A revolute joint constraint, as the joint anchor and axis fixed in the
+// frames of its parent and child links at the initial configuration.
+// When the constraint holds, both links map them to the same world point
+// and direction.
+struct JointConstraint
+{
+  physics::LinkPtr parent;
+  physics::LinkPtr child;
+  ignition::math::Vector3d anchorInParent;
+  ignition::math::Vector3d anchorInChild;
+  ignition::math::Vector3d axisInParent;
+  ignition::math::Vector3d axisInChild;
+};
+
+/////////////////////////////////////////////////
+// Express a world point and direction in the frame of a link,
+// or in the world frame for a joint to the world.
+static void ToLinkFrame(const physics::LinkPtr &_link,
+    const ignition::math::Vector3d &_point,
+    const ignition::math::Vector3d &_axis,
+    ignition::math::Vector3d &_pointInLink,
+    ignition::math::Vector3d &_axisInLink)
+{
+  if (!_link)
+  {
+    _pointInLink = _point;
+    _axisInLink = _axis;
+    return;
+  }
+  const ignition::math::Pose3d pose = _link->WorldPose();
+  _pointInLink = pose.Rot().RotateVectorReverse(_point - pose.Pos());
+  _axisInLink = pose.Rot().RotateVectorReverse(_axis);
+}
+
+/////////////////////////////////////////////////
+// Express a point and direction of a link frame in the world frame.
+static void ToWorldFrame(const physics::LinkPtr &_link,
+    const ignition::math::Vector3d &_pointInLink,
+    const ignition::math::Vector3d &_axisInLink,
+    ignition::math::Vector3d &_point,
+    ignition::math::Vector3d &_axis)
+{
+  if (!_link)
+  {
+    _point = _pointInLink;
+    _axis = _axisInLink;
+    return;
+  }
+  const ignition::math::Pose3d pose = _link->WorldPose();
+  _point = pose.Pos() + pose.Rot().RotateVector(_pointInLink);
+  _axis = pose.Rot().RotateVector(_axisInLink);
+}
+
+/////////////////////////////////////////////////
+// Chain:
+// Swing an articulated chain or tree without contacts and record
+// computational cost per joint, energy conservation and joint drift
+void ArticulatedFixture::Chain(const std::string &_physicsEngine
+                             , double _dt
+                             , int _linkCount
+                             , bool _tree)
+{
+  ASSERT_GT(_linkCount, 0);
+  const double linkLength = 0.2;
+  WorldBuilder builder;
+  AddRevoluteChain(builder, _linkCount, _tree, linkLength);
+  const std::string worldFile = builder.WriteTemporary("articulated");
+  ASSERT_FALSE(worldFile.empty());
+  physics::WorldPtr world;
+  this->LoadPhysicsWorld(worldFile, _physicsEngine, world);
+  boost::filesystem::remove(worldFile);
+  if (this->HasFatalFailure())
+    return;
+  physics::PhysicsEnginePtr physics = world->Physics();
+
+  physics::ModelPtr model = world->ModelByName("chain");
+  ASSERT_NE(model, nullptr);
+  const physics::Link_V &links = model->GetLinks();
+  ASSERT_EQ(links.size(), static_cast<size_t>(_linkCount));
+  ASSERT_EQ(model->GetJointCount(), static_cast<unsigned int>(_linkCount));
+  this->Record("jointCount", model->GetJointCount());
+  this->Record("treeDepth", _tree ? std::floor(std::log2(_linkCount)) :
+      _linkCount - 1);
+
+  // Each joint is at the origin of its child link, about the world y axis
+  std::vector<JointConstraint> constraints;
+  for (const auto &joint : model->GetJoints())
+  {
+    JointConstraint constraint;
+    constraint.parent = joint->GetParent();
+    constraint.child = joint->GetChild();
+    ASSERT_NE(constraint.child, nullptr);
+    const ignition::math::Vector3d anchor =
+        constraint.child->WorldPose().Pos();
+    const ignition::math::Vector3d axis = ignition::math::Vector3d::UnitY;
+    ToLinkFrame(constraint.parent, anchor, axis,
+        constraint.anchorInParent, constraint.axisInParent);
+    ToLinkFrame(constraint.child, anchor, axis,
+        constraint.anchorInChild, constraint.axisInChild);
+    constraints.push_back(constraint);
+  }
+
+  // Energy errors are relative to the potential energy of the full
+  // model falling one reach, since the initial energy depends on the
+  // height of the model.
+  const double reach = linkLength * (_tree ?
+      std::floor(std::log2(_linkCount)) + 1 : _linkCount);
+  const double energyScale =
+      _linkCount * links[0]->GetInertial()->Mass() *
+      world->Gravity().Length() * reach;
+  double E0 = 0.0;
+  for (const auto &link : links)
+    E0 += link->GetWorldEnergy();
+
+  physics->SetMaxStepSize(_dt);
+  const double simDuration = 2.0;
+  const int steps = ceil(simDuration / _dt);
+
+  // variables to compute statistics on
+  ignition::math::SignalStats anchorError;
+  ignition::math::SignalStats axisError;
+  ignition::math::SignalStats energyError;
+  {
+    const std::string statNames = "maxAbs";
+    EXPECT_TRUE(anchorError.InsertStatistics(statNames));
+    EXPECT_TRUE(axisError.InsertStatistics(statNames));
+    EXPECT_TRUE(energyError.InsertStatistics(statNames));
+  }
+
+  // unthrottle update rate
+  physics->SetRealTimeUpdateRate(0.0);
+  StepTimer stepTimer;
+  const common::Time t0 = world->SimTime();
+  const common::Time startTime = common::Time::GetWallTime();
+  for (int i = 0; i < steps; ++i)
+  {
+    stepTimer.Start();
+    this->StepWorld(world, 1);
+    stepTimer.Stop();
+
+    // worst joint anchor separation and axis misalignment (sine of the
+    // angle between the axes seen from the parent and the child)
+    double maxAnchorError = 0.0;
+    double maxAxisError = 0.0;
+    for (const auto &constraint : constraints)
+    {
+      ignition::math::Vector3d parentAnchor, parentAxis;
+      ignition::math::Vector3d childAnchor, childAxis;
+      ToWorldFrame(constraint.parent, constraint.anchorInParent,
+          constraint.axisInParent, parentAnchor, parentAxis);
+      ToWorldFrame(constraint.child, constraint.anchorInChild,
+          constraint.axisInChild, childAnchor, childAxis);
+      maxAnchorError = std::max(maxAnchorError,
+          (parentAnchor - childAnchor).Length());
+      maxAxisError = std::max(maxAxisError,
+          parentAxis.Cross(childAxis).Length());
+    }
+    anchorError.InsertData(maxAnchorError);
+    axisError.InsertData(maxAxisError);
+
+    double E = 0.0;
+    for (const auto &link : links)
+      E += link->GetWorldEnergy();
+    energyError.InsertData((E - E0) / energyScale);
+  }
+  const common::Time elapsedTime = common::Time::GetWallTime() - startTime;
+  const common::Time simTime = world->SimTime() - t0;
+  ASSERT_NEAR(simTime.Double(), simDuration, _dt*1.1);
+
+  this->RecordStepTimes(stepTimer, elapsedTime, simTime);
+
+  // Cost of each joint per step, to compare the growth with the number
+  // of joints across engines
+  this->Record("jointStepTime",
+      stepTimer.Total() / stepTimer.Count() / _linkCount);
+  this->Record("jointStepsPerSecond", static_cast<double>(_linkCount) *
+      stepTimer.Count() / stepTimer.Total());
+
+  this->Record("energyScale", energyScale);
+  this->Record("energyError_", energyError);
+  this->Record("jointAnchorErr_", anchorError);
+  this->Record("jointAxisErr_", axisError);
+}
+
+/////////////////////////////////////////////////
+TEST_P(ArticulatedTest, Chain)
+{
+  std::string physicsEngine = std::tr1::get<0>(GetParam());
+  double dt                 = std::tr1::get<1>(GetParam());
+  int linkCount             = std::tr1::get<2>(GetParam());
+  bool tree                 = std::tr1::get<3>(GetParam());
+  gzdbg << physicsEngine
+        << ", dt: " << dt
+        << ", linkCount: " << linkCount
+        << ", tree: " << tree
+        << std::endl;
+  RecordProperty("engine", physicsEngine);
+  this->Record("dt", dt);
+  RecordProperty("linkCount", linkCount);
+  RecordProperty("tree", tree);
+  Chain(physicsEngine
+      , dt
+      , linkCount
+      , tree);
+}
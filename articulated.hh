@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef BENCHMARK_GAZEBO_ARTICULATED_HH_
+#define BENCHMARK_GAZEBO_ARTICULATED_HH_
+
+#include <string>
+#include "benchmark_fixture.hh"
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Fixture for articulated models of many links connected by
+    /// revolute joints, to measure the cost of the joint solver.
+    class ArticulatedFixture : public BenchmarkFixture
+    {
+      /// \brief Swing a chain or tree of links under gravity (see
+      /// AddRevoluteChain) and record the step time, the cost per joint,
+      /// the energy error and the drift of the joint constraints.
+      /// \param[in] _physicsEngine Physics engine to use.
+      /// \param[in] _dt Max time step size.
+      /// \param[in] _linkCount Number of links and joints.
+      /// \param[in] _tree Binary tree instead of a serial chain.
+      public: void Chain(const std::string &_physicsEngine
+                       , double _dt
+                       , int _linkCount
+                       , bool _tree);
+    };
+
+    // physics engine
+    // dt
+    // number of links
+    // tree on / off
+    typedef std::tr1::tuple < const char *
+                            , double
+                            , int
+                            , bool
+                            > char1double1int1bool1;
+    class ArticulatedTest : public ArticulatedFixture,
+        public testing::WithParamInterface<char1double1int1bool1>
+    {
+    };
+  }
+}
+#endif
@@ -0,0 +1,488 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <string>
+#include <vector>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "gazebo/gazebo.hh"
+#include "gazebo/physics/World.hh"
+#include "benchmark_fixture.hh"
+#include "benchmark_options.hh"
+#include "cpu_affinity.hh"
+#include "result_sink.hh"
+#include "world_builder.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::SetUp()
+{
+  ServerFixture::SetUp();
+
+  // Threads started by Load() inherit the affinity of this thread,
+  // so pin it before the server is started.
+  const std::string transportCpus = OptionString("BENCHMARK_TRANSPORT_CPUS");
+  if (!transportCpus.empty() && !SetThreadAffinity(transportCpus))
+  {
+    gzwarn << "Unable to pin transport threads to cpus ["
+           << transportCpus << "]" << std::endl;
+  }
+
+  SetAllocationCounting(OptionBool("BENCHMARK_COUNT_ALLOCATIONS", false));
+
+  this->recordedValues.clear();
+  this->headless = false;
+
+  Telemetry &telemetry = LiveTelemetry();
+  telemetry.Reset();
+  const testing::TestInfo *info =
+      testing::UnitTest::GetInstance()->current_test_info();
+  telemetry.SetInfo("test",
+      std::string(info->test_case_name()) + "." + info->name());
+
+#ifdef BENCHMARK_PROFILE
+  this->profiler.reset(new StepProfiler());
+  this->profiler->Connect();
+  const int traceSteps = OptionInt("BENCHMARK_TRACE_STEPS", 0);
+  if (traceSteps > 0)
+    this->profiler->EnableTrace(traceSteps);
+#endif
+
+  // The world update thread is moved to the physics cores
+  // from inside its first update.
+  this->physicsThreadConfigured = false;
+  this->physicsThreadId = 0;
+  this->physicsAffinity = ThreadAffinityMask();
+  this->updateConnection = event::Events::ConnectWorldUpdateBegin(
+      [this](const common::UpdateInfo &)
+      {
+        this->OnWorldUpdateBegin();
+      });
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::TearDown()
+{
+  this->updateConnection.reset();
+
+  RecordProperty("cpuModel", CpuModel());
+  RecordProperty("cpuGovernor", CpuGovernor());
+  RecordProperty("transportAffinity", ThreadAffinityMask());
+  RecordProperty("physicsAffinity", this->physicsAffinity);
+  RecordProperty("physicsPriority", this->physicsPriority);
+  RecordProperty("allocationCounting", AllocationCounting());
+  if (this->profiler)
+  {
+    this->SetRecordCase(-1);
+    this->RecordProfile();
+    const std::string filename = OptionString("BENCHMARK_TRACE_DIR", ".") +
+        "/" + this->TestFileName() + ".trace.json";
+    if (this->profiler->WriteTrace(filename))
+      RecordProperty("traceFile", filename);
+    this->profiler->Disconnect();
+  }
+  this->WriteResults();
+
+  if (this->headless)
+    gazebo::shutdown();
+  ServerFixture::TearDown();
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::OnWorldUpdateBegin()
+{
+  if (this->physicsThreadConfigured)
+    return;
+  this->physicsThreadConfigured = true;
+  this->physicsThreadId = syscall(SYS_gettid);
+
+  const std::string physicsCpus = OptionString("BENCHMARK_PHYSICS_CPUS");
+  if (!physicsCpus.empty() && !SetThreadAffinity(physicsCpus))
+  {
+    gzwarn << "Unable to pin physics thread to cpus ["
+           << physicsCpus << "]" << std::endl;
+  }
+
+  const int priority = OptionInt("BENCHMARK_PHYSICS_PRIORITY", 0);
+  if (priority > 0)
+  {
+    if (SetThreadRealtimePriority(priority))
+    {
+      this->physicsPriority = priority;
+    }
+    else
+    {
+      gzwarn << "Unable to set physics thread priority to " << priority
+             << ", CAP_SYS_NICE may be required" << std::endl;
+    }
+  }
+  this->physicsAffinity = ThreadAffinityMask();
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::WriteResults() const
+{
+  const std::string filename = OptionString("BENCHMARK_RESULTS_FILE");
+  if (filename.empty())
+    return;
+
+  // Values recorded with a case suffix (see SetRecordCase) go to the row
+  // of that case, the others are shared by every row, as in
+  // junit_to_csv.rb.
+  const testing::TestInfo *info =
+      testing::UnitTest::GetInstance()->current_test_info();
+  const testing::TestResult *result = info->result();
+  ResultRow shared;
+  std::map<int, ResultRow> cases;
+  for (int i = 0; i < result->test_property_count(); ++i)
+  {
+    const testing::TestProperty &property = result->GetTestProperty(i);
+    const std::string key = property.key();
+    ResultValue value;
+    auto recorded = this->recordedValues.find(key);
+    if (recorded != this->recordedValues.end())
+    {
+      value.numeric = true;
+      value.number = recorded->second;
+    }
+    else
+    {
+      value = ResultSink::Parse(property.value());
+    }
+
+    const size_t dot = key.rfind('.');
+    if (dot != std::string::npos && dot + 1 < key.size() &&
+        std::all_of(key.begin() + dot + 1, key.end(),
+          [](unsigned char _c) { return std::isdigit(_c); }))
+    {
+      cases[std::stoi(key.substr(dot + 1))][key.substr(0, dot)] = value;
+    }
+    else
+    {
+      shared[key] = value;
+    }
+  }
+  shared["classname"].text = info->test_case_name();
+  shared["name"].text = info->name();
+  shared["failed"].numeric = true;
+  shared["failed"].number = result->Failed();
+
+  std::vector<ResultRow> rows;
+  if (cases.empty())
+    rows.push_back(shared);
+  for (const auto &c : cases)
+  {
+    ResultRow row = shared;
+    row["name"].text += "." + std::to_string(c.first);
+    for (const auto &value : c.second)
+      row[value.first] = value.second;
+    rows.push_back(row);
+  }
+  ResultSink::Append(filename, rows);
+}
+
+/////////////////////////////////////////////////
+physics::WorldPtr BenchmarkFixture::LoadHeadless(const std::string &_sdf)
+{
+  if (!gazebo::setupServer())
+  {
+    gzerr << "Unable to set up an in-process server" << std::endl;
+    return physics::WorldPtr();
+  }
+  this->headless = true;
+  physics::WorldPtr world = LoadWorldSdf(_sdf);
+  if (world)
+  {
+    // persistent update loop, stopped by gazebo::shutdown in TearDown
+    world->SetPaused(true);
+    world->Run();
+  }
+  return world;
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::LoadPhysicsWorld(const std::string &_worldFile,
+                                        const std::string &_physicsEngine,
+                                        physics::WorldPtr &_world)
+{
+  this->Load(_worldFile, true, _physicsEngine);
+  _world = physics::get_world("default");
+  ASSERT_NE(_world, nullptr);
+
+  // Verify physics engine type
+  physics::PhysicsEnginePtr physics = _world->Physics();
+  ASSERT_NE(physics, nullptr);
+  ASSERT_EQ(physics->GetType(), _physicsEngine);
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::StepWorld(physics::WorldPtr _world, unsigned int _steps)
+{
+  if (this->profiler)
+    this->profiler->SubscribeDiagnostics(_world);
+  _world->Step(_steps);
+  LiveTelemetry().AddSteps(_steps, _world->SimTime().Double());
+}
+
+/////////////////////////////////////////////////
+int BenchmarkFixture::ReplayInterval() const
+{
+  if (OptionString("BENCHMARK_REPLAY_DIR").empty())
+    return 0;
+  return std::max(1, OptionInt("BENCHMARK_REPLAY_INTERVAL", 100));
+}
+
+/////////////////////////////////////////////////
+ReplayLog BenchmarkFixture::NewReplayLog() const
+{
+  return ReplayLog(OptionDouble("BENCHMARK_REPLAY_TOLERANCE", 0.0));
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::FinishReplay(const ReplayLog &_log,
+                                    const std::string &_suffix)
+{
+  const std::string dir = OptionString("BENCHMARK_REPLAY_DIR");
+  if (dir.empty())
+    return;
+  const std::string filename =
+      dir + "/" + this->TestFileName() + _suffix + ".replay";
+  this->Record("replayCheckpoints", _log.Count());
+
+  if (!OptionBool("BENCHMARK_REPLAY_CHECK", false))
+  {
+    EXPECT_TRUE(_log.Write(filename)) << filename;
+    RecordProperty("replayFile", filename);
+    return;
+  }
+
+  ReplayLog reference;
+  if (!reference.Read(filename))
+  {
+    ADD_FAILURE() << "Unable to read the reference replay log "
+                  << filename;
+    return;
+  }
+  if (reference.Tolerance() != _log.Tolerance())
+  {
+    ADD_FAILURE() << "Reference replay log " << filename
+                  << " was written with BENCHMARK_REPLAY_TOLERANCE="
+                  << reference.Tolerance() << ", not "
+                  << _log.Tolerance();
+    return;
+  }
+  const int64_t divergence = _log.FirstDivergence(reference);
+  this->Record("replayMatched", divergence < 0);
+  this->Record("replayDivergentStep", divergence);
+  if (divergence >= 0)
+  {
+    gzwarn << "State differs from " << filename
+           << " after step " << divergence << std::endl;
+  }
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::RecordProfile()
+{
+  if (!this->profiler)
+    return;
+  const uint64_t steps = this->profiler->Steps();
+  if (steps == 0)
+    return;
+  this->Record("profileSteps", steps);
+  for (int i = 0; i < StepProfiler::kPhaseCount; ++i)
+  {
+    const auto phase = static_cast<StepProfiler::Phase>(i);
+    const std::string name =
+        std::string("profile_") + StepProfiler::Name(phase) + "Time";
+    const double total = this->profiler->Total(phase);
+    this->Record(name, total);
+    this->Record(name + "PerStep", total / steps);
+  }
+
+  // Timer names such as ODEPhysics::UpdateCollision
+  for (const auto &timer : this->profiler->DiagnosticTotals())
+  {
+    std::string name = timer.first;
+    for (char &c : name)
+    {
+      if (!std::isalnum(static_cast<unsigned char>(c)))
+        c = '_';
+    }
+    this->Record("profileDiag_" + name + "Time", timer.second);
+  }
+  this->profiler->Reset();
+}
+
+/////////////////////////////////////////////////
+Telemetry &BenchmarkFixture::LiveTelemetry()
+{
+  // Started with the first test, and kept running between tests
+  static Telemetry telemetry;
+  static const bool started = [&]()
+  {
+    const int port = OptionInt("BENCHMARK_TELEMETRY_PORT", 0);
+    return port > 0 && telemetry.Start(port,
+        OptionString("BENCHMARK_TELEMETRY_ADDRESS", "127.0.0.1"));
+  }();
+  static_cast<void>(started);
+  return telemetry;
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::RecordProperty(const std::string &_key,
+                                      const std::string &_value)
+{
+  ServerFixture::RecordProperty(_key, _value);
+  LiveTelemetry().SetInfo(_key, _value);
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::RecordProperty(const std::string &_key, int _value)
+{
+  ServerFixture::RecordProperty(_key, _value);
+  LiveTelemetry().SetInfo(_key, std::to_string(_value));
+}
+
+/////////////////////////////////////////////////
+int BenchmarkFixture::PhysicsThreadId() const
+{
+  return this->physicsThreadId;
+}
+
+/////////////////////////////////////////////////
+std::string BenchmarkFixture::TestFileName() const
+{
+  const testing::TestInfo *info =
+      testing::UnitTest::GetInstance()->current_test_info();
+  std::string name =
+      std::string(info->test_case_name()) + "_" + info->name();
+  std::replace(name.begin(), name.end(), '/', '_');
+  return name;
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::SetRecordCase(int _index)
+{
+  if (_index < 0)
+    this->recordSuffix.clear();
+  else
+    this->recordSuffix = "." + std::to_string(_index);
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::Record(const std::string &_name, double _data)
+{
+  this->recordedValues[_name + this->recordSuffix] = _data;
+  LiveTelemetry().SetValue(_name + this->recordSuffix, _data);
+  ServerFixture::Record(_name + this->recordSuffix, _data);
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::Record(const std::string &_prefix,
+                              const ignition::math::SignalStats &_stats)
+{
+  for (const auto &stat : _stats.Map())
+    this->Record(_prefix + stat.first, stat.second);
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::Record(const std::string &_prefix,
+                              const ignition::math::Vector3Stats &_stats)
+{
+  this->Record(_prefix + "_x_", _stats.X());
+  this->Record(_prefix + "_y_", _stats.Y());
+  this->Record(_prefix + "_z_", _stats.Z());
+  this->Record(_prefix + "_mag_", _stats.Mag());
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::Record(const std::string &_prefix,
+                              const StepTimer &_timer)
+{
+  this->Record(_prefix + "mean", _timer.Mean());
+  this->Record(_prefix + "p50", _timer.Quantile(0.5));
+  this->Record(_prefix + "p90", _timer.Quantile(0.9));
+  this->Record(_prefix + "p99", _timer.Quantile(0.99));
+  this->Record(_prefix + "p999", _timer.Quantile(0.999));
+  this->Record(_prefix + "max", _timer.Max());
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::RecordStepTimes(const StepTimer &_timer,
+                                       const common::Time &_wallTime,
+                                       const common::Time &_simTime)
+{
+  this->Record("wallTime", _wallTime.Double());
+  this->Record("simTime", _simTime.Double());
+  this->Record("timeRatio", _wallTime.Double() / _simTime.Double());
+  this->Record("stepWallTime", _timer.Total());
+  this->Record("stepTimeRatio", _timer.Total() / _simTime.Double());
+  this->Record("stepLatency_", _timer);
+  this->Record("stepsPerSecond", _timer.Count() / _timer.Total());
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::Record(const std::string &_prefix,
+                              const TrialStats &_stats)
+{
+  this->Record(_prefix + "mean", _stats.Mean());
+  this->Record(_prefix + "stddev", _stats.StdDev());
+  this->Record(_prefix + "min", _stats.Min());
+  this->Record(_prefix + "max", _stats.Max());
+  this->Record(_prefix + "ci95", _stats.ConfidenceInterval95());
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::Record(const std::string &_prefix,
+                              const MemoryStats &_stats)
+{
+  this->Record(_prefix + "peakRss", _stats.PeakRss());
+  this->Record(_prefix + "rssGrowth", _stats.RssGrowth());
+  this->Record(_prefix + "allocationsPerStep", _stats.AllocationsPerStep());
+  this->Record(_prefix + "allocatedBytesPerStep",
+      _stats.AllocatedBytesPerStep());
+}
+
+/////////////////////////////////////////////////
+void BenchmarkFixture::Record(const std::string &_prefix,
+                              const PerfCounters &_counters,
+                              uint64_t _steps)
+{
+  if (_steps == 0)
+    return;
+  for (int i = 0; i < PerfCounters::kEventCount; ++i)
+  {
+    const auto event = static_cast<PerfCounters::Event>(i);
+    if (_counters.Available(event))
+    {
+      this->Record(_prefix + PerfCounters::Name(event) + "PerStep",
+          _counters.Value(event) / _steps);
+    }
+  }
+  const double cycles = _counters.Value(PerfCounters::kCycles);
+  if (_counters.Available(PerfCounters::kInstructions) && cycles > 0)
+  {
+    this->Record(_prefix + "ipc",
+        _counters.Value(PerfCounters::kInstructions) / cycles);
+  }
+}
@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_BENCHMARK_FIXTURE_HH_
+#define BENCHMARK_GAZEBO_BENCHMARK_FIXTURE_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <ignition/math/SignalStats.hh>
+#include <ignition/math/Vector3Stats.hh>
+#include "gazebo/common/Events.hh"
+#include "gazebo/physics/PhysicsTypes.hh"
+#include "gazebo/test/ServerFixture.hh"
+#include "memory_stats.hh"
+#include "perf_counters.hh"
+#include "replay_log.hh"
+#include "step_profiler.hh"
+#include "step_timer.hh"
+#include "telemetry.hh"
+#include "trial_stats.hh"
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Common base class for the benchmark fixtures.
+    ///
+    /// The following environment variables control where the simulation
+    /// runs, to make timings reproducible on shared hosts:
+    ///
+    /// BENCHMARK_TRANSPORT_CPUS: core list (such as "1-3") for the test
+    /// thread and every gzserver thread it starts (transport, sensors).
+    /// BENCHMARK_PHYSICS_CPUS: core list for the world update thread,
+    /// which runs the physics engine.
+    /// BENCHMARK_PHYSICS_PRIORITY: SCHED_FIFO priority (1-99) for the
+    /// world update thread, 0 to leave it unchanged.
+    /// BENCHMARK_COUNT_ALLOCATIONS: set to 0 to stop counting heap
+    /// allocations, which adds an atomic increment to each allocation.
+    /// BENCHMARK_PERF_COUNTERS: set to 1 to record hardware performance
+    /// counters of the stepping loops, where the fixtures support it.
+    /// BENCHMARK_RESULTS_FILE: file to append the recorded values of each
+    /// test to with ResultSink, in addition to the junit file.
+    /// BENCHMARK_TELEMETRY_PORT: TCP port serving live progress of the
+    /// tests in Prometheus text format, see Telemetry.
+    /// BENCHMARK_REPLAY_DIR: folder of the ReplayLog files of each test,
+    /// written by reference runs or compared against with
+    /// BENCHMARK_REPLAY_CHECK=1. BENCHMARK_REPLAY_INTERVAL sets the steps
+    /// between checkpoints and BENCHMARK_REPLAY_TOLERANCE the tolerance
+    /// of a bounded comparison of the states instead of their hashes.
+    ///
+    /// Executables built with BENCHMARK_PROFILE defined (the
+    /// BENCHMARK_*_profile variants) record the time of each world update
+    /// phase with a StepProfiler. BENCHMARK_TRACE_STEPS keeps the phases
+    /// of the first world updates of each test as a chrome://tracing file
+    /// in BENCHMARK_TRACE_DIR (default: working directory).
+    ///
+    /// The CPU model, frequency governor and resulting affinity masks are
+    /// recorded as test properties.
+    class BenchmarkFixture : public ServerFixture
+    {
+      /// \brief Apply cpu affinity options before the server starts.
+      protected: virtual void SetUp();
+
+      /// \brief Record host properties and unload the server.
+      protected: virtual void TearDown();
+
+      /// \brief Name of the current test usable as a file name, such as
+      /// EnginesDtSimple_BoxesTest_Boxes_0.
+      protected: std::string TestFileName() const;
+
+      /// \brief Load a world in this process, without the gzserver started
+      /// by ServerFixture::Load and its sensors and rendering. Transport is
+      /// limited to the in-process master of gazebo::setupServer. The
+      /// world update loop is started once, paused, so that StepWorld
+      /// steps it with World::Step exactly like a gzserver world instead
+      /// of re-entering the loop setup of gazebo::runWorld on every call.
+      /// A test can load at most one world this way, and not together with
+      /// ServerFixture::Load.
+      /// \param[in] _sdf World sdf, such as WorldBuilder::ToString, with
+      /// the physics engine set. It is parsed in memory, without a file.
+      /// \return The loaded world, or nullptr.
+      protected: physics::WorldPtr LoadHeadless(const std::string &_sdf);
+
+      /// \brief Load a world file with ServerFixture::Load, paused, and
+      /// check that it uses the given physics engine.
+      /// Call with ASSERT_NO_FATAL_FAILURE.
+      /// \param[in] _worldFile World file.
+      /// \param[in] _physicsEngine Physics engine to use.
+      /// \param[out] _world The loaded world.
+      protected: void LoadPhysicsWorld(const std::string &_worldFile,
+                                       const std::string &_physicsEngine,
+                                       physics::WorldPtr &_world);
+
+      /// \brief Step a world with World::Step and wait for the steps to
+      /// finish, counting the steps for telemetry and profiling.
+      /// \param[in] _world World to step.
+      /// \param[in] _steps Number of steps.
+      protected: void StepWorld(physics::WorldPtr _world, unsigned int _steps);
+
+      /// \brief Number of steps between replay checkpoints.
+      /// \return BENCHMARK_REPLAY_INTERVAL (default 100), or 0 if
+      /// BENCHMARK_REPLAY_DIR is not set.
+      protected: int ReplayInterval() const;
+
+      /// \brief Empty replay log with the BENCHMARK_REPLAY_TOLERANCE.
+      protected: ReplayLog NewReplayLog() const;
+
+      /// \brief Write the replay log of the current test, or of one case
+      /// of it, to BENCHMARK_REPLAY_DIR, or with BENCHMARK_REPLAY_CHECK
+      /// compare it with the log of a reference run and record
+      /// replayMatched and replayDivergentStep (-1 when matched).
+      /// \param[in] _log Checkpoints of the test or case.
+      /// \param[in] _suffix Suffix of the file name, such as _dt2.
+      protected: void FinishReplay(const ReplayLog &_log,
+                                   const std::string &_suffix = "");
+
+      /// \brief Record the phase totals of the world updates since the
+      /// last call, such as profile_physicsTime and
+      /// profile_physicsTimePerStep, and the diagnostics timer totals, as
+      /// profileDiag_<timer>Time. Does nothing unless built with
+      /// BENCHMARK_PROFILE; otherwise called by TearDown for the updates
+      /// that were not recorded yet.
+      protected: void RecordProfile();
+
+      /// \brief Live telemetry of this process, shared by all tests.
+      /// Steps taken with StepWorld, recorded values and properties are
+      /// published automatically; fixtures can add live gauges.
+      protected: static Telemetry &LiveTelemetry();
+
+      /// \brief Record a property, also published as a telemetry label.
+      /// Hides testing::Test::RecordProperty.
+      /// \param[in] _key Property name.
+      /// \param[in] _value Property value.
+      protected: void RecordProperty(const std::string &_key,
+                                     const std::string &_value);
+
+      /// \brief Record an integer property, also published as a
+      /// telemetry label.
+      /// \param[in] _key Property name.
+      /// \param[in] _value Property value.
+      protected: void RecordProperty(const std::string &_key, int _value);
+
+      /// \brief Linux thread id of the world update thread, which runs the
+      /// physics engine, or 0 before its first update.
+      protected: int PhysicsThreadId() const;
+
+      /// \brief Append .<index> to every name recorded from now on, so a
+      /// single test can record several cases, such as the time step
+      /// sizes of a sweep. junit_to_csv.rb writes each case as its own
+      /// row, sharing the values recorded without an index.
+      /// \param[in] _index Case index, or a negative value to stop.
+      protected: void SetRecordCase(int _index);
+
+      /// \brief Record a value.
+      /// \param[in] _name Name of the value.
+      /// \param[in] _data Value.
+      protected: void Record(const std::string &_name, double _data);
+
+      /// \brief Record signal statistics, such as <prefix>maxAbs.
+      /// \param[in] _prefix Prefix for each recorded value.
+      /// \param[in] _stats Signal statistics.
+      protected: void Record(const std::string &_prefix,
+                             const ignition::math::SignalStats &_stats);
+
+      /// \brief Record statistics of each vector component and the
+      /// magnitude, such as <prefix>_x_maxAbs and <prefix>_mag_maxAbs.
+      /// \param[in] _prefix Prefix for each recorded value.
+      /// \param[in] _stats Vector statistics.
+      protected: void Record(const std::string &_prefix,
+                             const ignition::math::Vector3Stats &_stats);
+
+      /// \brief Record step latency statistics from a StepTimer:
+      /// mean, p50, p90, p99, p999 (99.9th percentile) and max.
+      /// \param[in] _prefix Prefix for each recorded value.
+      /// \param[in] _timer Step timer with recorded samples.
+      protected: void Record(const std::string &_prefix,
+                             const StepTimer &_timer);
+
+      /// \brief Record the timing of a timed stepping loop: wallTime,
+      /// simTime, timeRatio, stepWallTime and stepTimeRatio (time inside
+      /// the steps only), stepLatency_ and stepsPerSecond.
+      /// \param[in] _timer Step timer of the loop.
+      /// \param[in] _wallTime Wall time of the loop.
+      /// \param[in] _simTime Sim time of the loop.
+      protected: void RecordStepTimes(const StepTimer &_timer,
+                                      const common::Time &_wallTime,
+                                      const common::Time &_simTime);
+
+      /// \brief Record statistics over repeated trials:
+      /// mean, stddev, min, max and ci95 (95% confidence interval
+      /// half-width of the mean).
+      /// \param[in] _prefix Prefix for each recorded value.
+      /// \param[in] _stats Trial statistics.
+      protected: void Record(const std::string &_prefix,
+                             const TrialStats &_stats);
+
+      /// \brief Record memory use over an interval: peakRss, rssGrowth,
+      /// allocationsPerStep and allocatedBytesPerStep, in bytes.
+      /// Allocations are -1 when they are not counted.
+      /// \param[in] _prefix Prefix for each recorded value.
+      /// \param[in] _stats Memory statistics.
+      protected: void Record(const std::string &_prefix,
+                             const MemoryStats &_stats);
+
+      /// \brief Record performance counters over an interval: available
+      /// events per step (such as instructionsPerStep) and ipc
+      /// (instructions per cycle). Unavailable events are not recorded.
+      /// \param[in] _prefix Prefix for each recorded value.
+      /// \param[in] _counters Stopped performance counters.
+      /// \param[in] _steps Number of steps in the interval.
+      protected: void Record(const std::string &_prefix,
+                             const PerfCounters &_counters,
+                             uint64_t _steps);
+
+      /// \brief Pin the world update thread on its first update.
+      private: void OnWorldUpdateBegin();
+
+      /// \brief Append the properties of the current test to the
+      /// BENCHMARK_RESULTS_FILE, one row per recorded case.
+      private: void WriteResults() const;
+
+      /// \brief Phase timers of BENCHMARK_PROFILE builds, null otherwise.
+      private: std::unique_ptr<StepProfiler> profiler;
+
+      /// \brief True if the world was loaded by LoadHeadless.
+      private: bool headless = false;
+
+      /// \brief Values recorded by the current test at full precision.
+      private: std::map<std::string, double> recordedValues;
+
+      /// \brief Connection to the world update begin event.
+      private: event::ConnectionPtr updateConnection;
+
+      /// \brief True once the world update thread has been configured.
+      private: std::atomic<bool> physicsThreadConfigured;
+
+      /// \brief Affinity mask of the world update thread.
+      private: std::string physicsAffinity;
+
+      /// \brief Thread id of the world update thread.
+      private: std::atomic<int> physicsThreadId;
+
+      /// \brief Real-time priority applied to the world update thread.
+      private: int physicsPriority = 0;
+
+      /// \brief Suffix appended to recorded names, see SetRecordCase.
+      private: std::string recordSuffix;
+    };
+  }
+}
+#endif
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <cstdlib>
+#include <string>
+
+#include "benchmark_options.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+std::string benchmark::OptionString(const std::string &_name,
+                                    const std::string &_default)
+{
+  const char *value = std::getenv(_name.c_str());
+  if (value == nullptr)
+    return _default;
+  return value;
+}
+
+/////////////////////////////////////////////////
+double benchmark::OptionDouble(const std::string &_name, double _default)
+{
+  const std::string value = OptionString(_name);
+  if (value.empty())
+    return _default;
+  char *end = nullptr;
+  const double result = std::strtod(value.c_str(), &end);
+  if (end == value.c_str() || *end != '\0')
+    return _default;
+  return result;
+}
+
+/////////////////////////////////////////////////
+int benchmark::OptionInt(const std::string &_name, int _default)
+{
+  const std::string value = OptionString(_name);
+  if (value.empty())
+    return _default;
+  char *end = nullptr;
+  const long result = std::strtol(value.c_str(), &end, 10);
+  if (end == value.c_str() || *end != '\0')
+    return _default;
+  return static_cast<int>(result);
+}
+
+/////////////////////////////////////////////////
+bool benchmark::OptionBool(const std::string &_name, bool _default)
+{
+  const std::string value = OptionString(_name);
+  if (value == "1" || value == "true" || value == "on")
+    return true;
+  if (value == "0" || value == "false" || value == "off")
+    return false;
+  return _default;
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_BENCHMARK_OPTIONS_HH_
+#define BENCHMARK_GAZEBO_BENCHMARK_OPTIONS_HH_
+
+#include <string>
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    // Benchmark options are read from environment variables so they can
+    // be set per test with the ctest ENVIRONMENT property or by
+    // tools/sweep_runner.py without changing the gtest parameter grids.
+
+    /// \brief Read a string option.
+    /// \param[in] _name Environment variable name, such as
+    /// BENCHMARK_PHYSICS_CPUS.
+    /// \param[in] _default Value returned if the variable is not set.
+    std::string OptionString(const std::string &_name,
+                             const std::string &_default = "");
+
+    /// \brief Read a floating point option.
+    /// \param[in] _name Environment variable name.
+    /// \param[in] _default Value returned if the variable is not set
+    /// or cannot be parsed.
+    double OptionDouble(const std::string &_name, double _default);
+
+    /// \brief Read an integer option.
+    /// \param[in] _name Environment variable name.
+    /// \param[in] _default Value returned if the variable is not set
+    /// or cannot be parsed.
+    int OptionInt(const std::string &_name, int _default);
+
+    /// \brief Read a boolean option, accepting 1/0, true/false, on/off.
+    /// \param[in] _name Environment variable name.
+    /// \param[in] _default Value returned if the variable is not set
+    /// or cannot be parsed.
+    bool OptionBool(const std::string &_name, bool _default);
+  }
+}
+#endif
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <algorithm>
+#include <cmath>
+
+#include "body_errors.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+// Square root of the largest element.
+static double MaxSqrt(const std::vector<double> &_v)
+{
+  if (_v.empty())
+    return 0.0;
+  return std::sqrt(*std::max_element(_v.begin(), _v.end()));
+}
+
+/////////////////////////////////////////////////
+// Mean of the square roots of the elements.
+static double MeanSqrt(const std::vector<double> &_v)
+{
+  if (_v.empty())
+    return 0.0;
+  double sum = 0.0;
+  for (const double x : _v)
+    sum += std::sqrt(x);
+  return sum / _v.size();
+}
+
+/////////////////////////////////////////////////
+void BodyErrors::Resize(size_t _count)
+{
+  for (auto *v : {&p0x, &p0y, &p0z, &v0x, &v0y, &v0z, &H0x, &H0y, &H0z,
+                  &invH0mag2, &px, &py, &pz, &vx, &vy, &vz, &Hx, &Hy, &Hz,
+                  &maxPosition2, &maxVelocity2, &maxMomentum2})
+  {
+    v->assign(_count, 0.0);
+  }
+}
+
+/////////////////////////////////////////////////
+size_t BodyErrors::Size() const
+{
+  return this->px.size();
+}
+
+/////////////////////////////////////////////////
+void BodyErrors::SetInitialState(size_t _i,
+    const ignition::math::Vector3d &_p0,
+    const ignition::math::Vector3d &_v0,
+    const ignition::math::Vector3d &_H0)
+{
+  this->p0x[_i] = _p0.X();
+  this->p0y[_i] = _p0.Y();
+  this->p0z[_i] = _p0.Z();
+  this->v0x[_i] = _v0.X();
+  this->v0y[_i] = _v0.Y();
+  this->v0z[_i] = _v0.Z();
+  this->H0x[_i] = _H0.X();
+  this->H0y[_i] = _H0.Y();
+  this->H0z[_i] = _H0.Z();
+  this->invH0mag2[_i] = 1.0 / _H0.SquaredLength();
+}
+
+/////////////////////////////////////////////////
+void BodyErrors::SetState(size_t _i,
+    const ignition::math::Vector3d &_p,
+    const ignition::math::Vector3d &_v,
+    const ignition::math::Vector3d &_H)
+{
+  this->px[_i] = _p.X();
+  this->py[_i] = _p.Y();
+  this->pz[_i] = _p.Z();
+  this->vx[_i] = _v.X();
+  this->vy[_i] = _v.Y();
+  this->vz[_i] = _v.Z();
+  this->Hx[_i] = _H.X();
+  this->Hy[_i] = _H.Y();
+  this->Hz[_i] = _H.Z();
+}
+
+/////////////////////////////////////////////////
+void BodyErrors::Update(double _t, const ignition::math::Vector3d &_g)
+{
+  const size_t n = this->Size();
+  const double gx = _g.X(), gy = _g.Y(), gz = _g.Z();
+  const double ht2 = 0.5 * _t * _t;
+
+  // raw pointers so the loops vectorize without aliasing checks
+  const double *__restrict p0xa = this->p0x.data();
+  const double *__restrict p0ya = this->p0y.data();
+  const double *__restrict p0za = this->p0z.data();
+  const double *__restrict v0xa = this->v0x.data();
+  const double *__restrict v0ya = this->v0y.data();
+  const double *__restrict v0za = this->v0z.data();
+  const double *__restrict pxa = this->px.data();
+  const double *__restrict pya = this->py.data();
+  const double *__restrict pza = this->pz.data();
+  const double *__restrict vxa = this->vx.data();
+  const double *__restrict vya = this->vy.data();
+  const double *__restrict vza = this->vz.data();
+  double *__restrict maxP = this->maxPosition2.data();
+  double *__restrict maxV = this->maxVelocity2.data();
+  for (size_t i = 0; i < n; ++i)
+  {
+    const double ex = pxa[i] - (p0xa[i] + v0xa[i] * _t + gx * ht2);
+    const double ey = pya[i] - (p0ya[i] + v0ya[i] * _t + gy * ht2);
+    const double ez = pza[i] - (p0za[i] + v0za[i] * _t + gz * ht2);
+    const double ep = ex * ex + ey * ey + ez * ez;
+    maxP[i] = ep > maxP[i] ? ep : maxP[i];
+
+    const double fx = vxa[i] - (v0xa[i] + gx * _t);
+    const double fy = vya[i] - (v0ya[i] + gy * _t);
+    const double fz = vza[i] - (v0za[i] + gz * _t);
+    const double ev = fx * fx + fy * fy + fz * fz;
+    maxV[i] = ev > maxV[i] ? ev : maxV[i];
+  }
+
+  const double *__restrict H0xa = this->H0x.data();
+  const double *__restrict H0ya = this->H0y.data();
+  const double *__restrict H0za = this->H0z.data();
+  const double *__restrict inv = this->invH0mag2.data();
+  const double *__restrict Hxa = this->Hx.data();
+  const double *__restrict Hya = this->Hy.data();
+  const double *__restrict Hza = this->Hz.data();
+  double *__restrict maxH = this->maxMomentum2.data();
+  for (size_t i = 0; i < n; ++i)
+  {
+    const double hx = Hxa[i] - H0xa[i];
+    const double hy = Hya[i] - H0ya[i];
+    const double hz = Hza[i] - H0za[i];
+    const double eh = (hx * hx + hy * hy + hz * hz) * inv[i];
+    maxH[i] = eh > maxH[i] ? eh : maxH[i];
+  }
+}
+
+/////////////////////////////////////////////////
+double BodyErrors::MaxPositionError() const
+{
+  return MaxSqrt(this->maxPosition2);
+}
+
+/////////////////////////////////////////////////
+double BodyErrors::MaxVelocityError() const
+{
+  return MaxSqrt(this->maxVelocity2);
+}
+
+/////////////////////////////////////////////////
+double BodyErrors::MaxMomentumError() const
+{
+  return MaxSqrt(this->maxMomentum2);
+}
+
+/////////////////////////////////////////////////
+double BodyErrors::MeanPositionError() const
+{
+  return MeanSqrt(this->maxPosition2);
+}
+
+/////////////////////////////////////////////////
+double BodyErrors::MeanVelocityError() const
+{
+  return MeanSqrt(this->maxVelocity2);
+}
+
+/////////////////////////////////////////////////
+double BodyErrors::MeanMomentumError() const
+{
+  return MeanSqrt(this->maxMomentum2);
+}
+
+/////////////////////////////////////////////////
+size_t BodyErrors::WorstBody() const
+{
+  return std::max_element(this->maxPosition2.begin(),
+                          this->maxPosition2.end())
+         - this->maxPosition2.begin();
+}
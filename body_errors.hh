@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_BODY_ERRORS_HH_
+#define BENCHMARK_GAZEBO_BODY_ERRORS_HH_
+
+#include <cstddef>
+#include <vector>
+#include <ignition/math/Vector3.hh>
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Accumulates the maximum position, velocity and angular
+    /// momentum errors of many free-floating bodies against their
+    /// analytical trajectories (constant gravity, conserved momentum).
+    ///
+    /// Expected and measured states are stored as structure-of-arrays,
+    /// so Update() is a branch-free loop over contiguous doubles that
+    /// the compiler can vectorize.
+    class BodyErrors
+    {
+      /// \brief Allocate storage and clear accumulated errors.
+      /// \param[in] _count Number of bodies.
+      public: void Resize(size_t _count);
+
+      /// \brief Number of bodies.
+      public: size_t Size() const;
+
+      /// \brief Set the initial state of a body.
+      /// \param[in] _i Body index.
+      /// \param[in] _p0 Initial center of mass position.
+      /// \param[in] _v0 Initial center of mass velocity.
+      /// \param[in] _H0 Initial angular momentum, must be non-zero.
+      public: void SetInitialState(size_t _i,
+                                   const ignition::math::Vector3d &_p0,
+                                   const ignition::math::Vector3d &_v0,
+                                   const ignition::math::Vector3d &_H0);
+
+      /// \brief Store the measured state of a body for the next Update.
+      /// \param[in] _i Body index.
+      /// \param[in] _p Center of mass position.
+      /// \param[in] _v Center of mass velocity.
+      /// \param[in] _H Angular momentum.
+      public: void SetState(size_t _i,
+                            const ignition::math::Vector3d &_p,
+                            const ignition::math::Vector3d &_v,
+                            const ignition::math::Vector3d &_H);
+
+      /// \brief Compare the stored states of all bodies with the
+      /// expected states and update the per-body maximum errors.
+      /// \param[in] _t Time since the initial state.
+      /// \param[in] _g Gravity vector.
+      public: void Update(double _t, const ignition::math::Vector3d &_g);
+
+      /// \brief Largest position error magnitude of any body.
+      public: double MaxPositionError() const;
+
+      /// \brief Largest velocity error magnitude of any body.
+      public: double MaxVelocityError() const;
+
+      /// \brief Largest angular momentum error of any body,
+      /// relative to its initial angular momentum magnitude.
+      public: double MaxMomentumError() const;
+
+      /// \brief Mean over bodies of the maximum position error magnitude.
+      public: double MeanPositionError() const;
+
+      /// \brief Mean over bodies of the maximum velocity error magnitude.
+      public: double MeanVelocityError() const;
+
+      /// \brief Mean over bodies of the maximum relative
+      /// angular momentum error.
+      public: double MeanMomentumError() const;
+
+      /// \brief Index of the body with the largest position error.
+      public: size_t WorstBody() const;
+
+      /// \brief Initial positions.
+      private: std::vector<double> p0x, p0y, p0z;
+
+      /// \brief Initial velocities.
+      private: std::vector<double> v0x, v0y, v0z;
+
+      /// \brief Initial angular momentum.
+      private: std::vector<double> H0x, H0y, H0z;
+
+      /// \brief Inverse squared magnitude of initial angular momentum.
+      private: std::vector<double> invH0mag2;
+
+      /// \brief Measured positions.
+      private: std::vector<double> px, py, pz;
+
+      /// \brief Measured velocities.
+      private: std::vector<double> vx, vy, vz;
+
+      /// \brief Measured angular momentum.
+      private: std::vector<double> Hx, Hy, Hz;
+
+      /// \brief Per-body maximum squared errors.
+      private: std::vector<double> maxPosition2, maxVelocity2, maxMomentum2;
+    };
+  }
+}
+#endif
@@ -14,55 +14,401 @@
  * limitations under the License.
  *
 */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <initializer_list>
+#include <limits>
+#include <map>
 #include <string>
+#include <utility>
+#include <vector>
 
+#include <boost/filesystem.hpp>
 #include <ignition/math/Pose3.hh>
 #include <ignition/math/Quaternion.hh>
 #include <ignition/math/Vector3.hh>
 
 #include "gazebo/msgs/msgs.hh"
 #include "gazebo/physics/physics.hh"
+#include "benchmark_options.hh"
+#include "body_errors.hh"
+#include "boxes_backend.hh"
 #include "boxes.hh"
+#include "dt_search.hh"
+#include "memory_stats.hh"
+#include "perf_counters.hh"
+#include "replay_log.hh"
+#include "step_observer.hh"
+#include "step_timer.hh"
+#include "telemetry.hh"
+#include "trajectory_writer.hh"
+#include "trial_stats.hh"
+#include "world_builder.hh"
+#include "world_snapshot.hh"
 
 using namespace gazebo;
 using namespace benchmark;
 
+/// \brief State of the tracked box after a step,
+/// passed to the analysis thread.
+struct BoxState
+{
+  /// \brief Time since the start of the trial.
+  double t = 0.0;
+
+  /// \brief Center of mass position.
+  ignition::math::Vector3d p;
+
+  /// \brief Center of mass linear velocity.
+  ignition::math::Vector3d v;
+
+  /// \brief Angular momentum.
+  ignition::math::Vector3d H;
+
+  /// \brief Euler angles, only set for simple trajectories.
+  ignition::math::Vector3d a;
+
+  /// \brief Energy.
+  double E = 0.0;
+};
+
 /////////////////////////////////////////////////
-// Boxes:
-// Spawn a single box and record accuracy for momentum and enery
-// conservation
-void BoxesTest::Boxes(const std::string &_physicsEngine
-                    , double _dt
-                    , int _modelCount
-                    , bool _collision
-                    , bool _complex)
-{
-  // Load a blank world (no ground plane)
-  Load("worlds/blank.world", true, _physicsEngine);
-  physics::WorldPtr world = physics::get_world("default");
-  ASSERT_NE(world, nullptr);
+// Round each component to the nearest single precision value.
+static ignition::math::Vector3d RoundToFloat(
+    const ignition::math::Vector3d &_v)
+{
+  return ignition::math::Vector3d(static_cast<float>(_v.X()),
+                                  static_cast<float>(_v.Y()),
+                                  static_cast<float>(_v.Z()));
+}
 
-  // Verify physics engine type
-  physics::PhysicsEnginePtr physics = world->Physics();
-  ASSERT_NE(physics, nullptr);
-  ASSERT_EQ(physics->GetType(), _physicsEngine);
+/////////////////////////////////////////////////
+// Round the pose and velocities of a link to single precision.
+static void RoundStateToFloat(physics::LinkPtr _link)
+{
+  const ignition::math::Pose3d pose = _link->WorldPose();
+  ignition::math::Quaterniond rot(static_cast<float>(pose.Rot().W()),
+                                  static_cast<float>(pose.Rot().X()),
+                                  static_cast<float>(pose.Rot().Y()),
+                                  static_cast<float>(pose.Rot().Z()));
+  rot.Normalize();
+  const ignition::math::Vector3d linearVel = _link->WorldLinearVel();
+  const ignition::math::Vector3d angularVel = _link->WorldAngularVel();
+  _link->SetWorldPose(ignition::math::Pose3d(RoundToFloat(pose.Pos()), rot));
+  _link->SetLinearVel(RoundToFloat(linearVel));
+  _link->SetAngularVel(RoundToFloat(angularVel));
+}
 
-  // get gravity value
+/////////////////////////////////////////////////
+// Contacts are only kept by the contact manager with a subscriber.
+static void OnPileContacts(ConstContactsPtr &/*_msg*/)
+{
+}
+
+/////////////////////////////////////////////////
+// Box size and mass, shared by Boxes, BoxesExternal and BoxesPile
+static const double kBoxDx = 0.1;
+static const double kBoxDy = 0.4;
+static const double kBoxDz = 0.9;
+static const double kBoxMass = 10.0;
+// expected principal moments of inertia, recompute if the above change
+static const double kBoxIxx = 0.80833333;
+static const double kBoxIyy = 0.68333333;
+static const double kBoxIzz = 0.14166667;
+
+/////////////////////////////////////////////////
+// Initial velocities and energy of the simple and complex trajectories.
+static void BoxInitialConditions(bool _complex,
+                                 ignition::math::Vector3d &_v0,
+                                 ignition::math::Vector3d &_w0,
+                                 double &_E0)
+{
   if (!_complex)
   {
-    world->SetGravity(ignition::math::Vector3d::Zero);
+    _v0.Set(-0.9, 0.4, 0.1);
+    // Use angular velocity with one non-zero component
+    // to ensure linear angular trajectory
+    _w0.Set(0.5, 0, 0);
+    _E0 = 5.001041625;
+  }
+  else
+  {
+    _v0.Set(-2.0, 2.0, 8.0);
+    // Since Ixx > Iyy > Izz,
+    // angular velocity with large y component
+    // will cause gyroscopic tumbling
+    _w0.Set(0.1, 5.0, 0.1);
+    _E0 = 368.54641249999997;
+  }
+}
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Boxes loaded by BoxesFixture::LoadBoxes and the initial
+    /// state of the tracked box, which is the last one.
+    struct BoxesWorld
+    {
+      /// \brief Loaded world.
+      physics::WorldPtr world;
+
+      /// \brief Physics engine of the world.
+      physics::PhysicsEnginePtr physics;
+
+      /// \brief Every box, in spawn order.
+      std::vector<physics::ModelPtr> models;
+
+      /// \brief Link of the tracked box.
+      physics::LinkPtr link;
+
+      /// \brief Snapshot of the initial state, restored before each trial
+      /// and each time step size of a sweep instead of reloading and
+      /// respawning.
+      WorldSnapshot snapshot;
+
+      /// \brief Initial linear velocity in global frame.
+      ignition::math::Vector3d v0;
+
+      /// \brief Initial angular velocity in global frame.
+      ignition::math::Vector3d w0;
+
+      /// \brief Gravity of the world.
+      ignition::math::Vector3d g;
+
+      /// \brief Initial position of the tracked box in global frame.
+      ignition::math::Vector3d p0;
+
+      /// \brief Initial angular momentum of the tracked box in global
+      /// frame.
+      ignition::math::Vector3d H0;
+
+      /// \brief Magnitude of H0.
+      double H0mag = 0.0;
+
+      /// \brief Initial energy of the tracked box.
+      double E0 = 0.0;
+    };
+
+    /// \brief Trial settings of BoxesFixture::Boxes, from BoxesOptions and
+    /// their environment variable overrides.
+    struct BoxesTrialSettings
+    {
+      /// \brief Untimed warm-up steps before the trials of each case.
+      int warmupSteps = 0;
+
+      /// \brief Number of timed trials of each case.
+      int trials = 1;
+
+      /// \brief Track the errors of every box.
+      bool allBodyErrors = false;
+
+      /// \brief Analyze the tracked box on a worker thread.
+      bool asyncAnalysis = true;
+
+      /// \brief Round the state of every box to single precision.
+      bool float32State = false;
+
+      /// \brief Performance counters of the world update thread are open.
+      bool perfCounters = false;
+
+      /// \brief Linear position error tolerance, 0 to disable.
+      double linPositionTolerance = 0.0;
+
+      /// \brief Angular momentum error tolerance, 0 to disable.
+      double angMomentumTolerance = 0.0;
+
+      /// \brief Relative error above which a trial diverged, 0 to disable.
+      double divergenceThreshold = 0.0;
+
+      /// \brief Number of steps between divergence checks.
+      int divergenceInterval = 100;
+
+      /// \brief True if trials are aborted above either tolerance.
+      bool ErrorBudget() const
+      {
+        return this->linPositionTolerance > 0 ||
+               this->angMomentumTolerance > 0;
+      }
+    };
+
+    /// \brief Measurements of the trials of one time step size case.
+    struct BoxesCase
+    {
+      /// \brief Linear position error of the tracked box.
+      ignition::math::Vector3Stats linearPositionError;
+
+      /// \brief Linear velocity error of the tracked box.
+      ignition::math::Vector3Stats linearVelocityError;
+
+      /// \brief Angular position error, only for simple trajectories.
+      ignition::math::Vector3Stats angularPositionError;
+
+      /// \brief Relative angular momentum error of the tracked box.
+      ignition::math::Vector3Stats angularMomentumError;
+
+      /// \brief Relative energy error of the tracked box.
+      ignition::math::SignalStats energyError;
+
+      /// \brief Links of every box, with allBodyErrors.
+      std::vector<physics::LinkPtr> links;
+
+      /// \brief Errors of every box, gathered into contiguous arrays after
+      /// each step, with allBodyErrors.
+      BodyErrors bodyErrors;
+
+      /// \brief Time spent inside each step.
+      StepTimer stepTimer;
+
+      /// \brief Time spent gathering the state of the tracked box.
+      StepTimer::Clock::duration analysisDuration =
+          StepTimer::Clock::duration::zero();
+
+      /// \brief Time spent updating the errors of every box.
+      StepTimer::Clock::duration allBodyDuration =
+          StepTimer::Clock::duration::zero();
+
+      /// \brief Wall time of each trial.
+      TrialStats wallTimes;
+
+      /// \brief Ratio of wall time to sim time of each trial.
+      TrialStats timeRatios;
+
+      /// \brief Sim time of the last trial.
+      common::Time simTime;
+
+      /// \brief Memory growth and heap allocations of the trials.
+      MemoryStats memory;
+
+      /// \brief State of the tracked box at every step of the first trial,
+      /// when BENCHMARK_TRAJECTORY_DIR is set.
+      TrajectoryWriter trajectory;
+
+      /// \brief State checkpoints of the first trial.
+      ReplayLog replay;
+
+      /// \brief Sim time at which the errors exceeded the tolerances,
+      /// -1 if never.
+      double overBudgetTime = -1.0;
+
+      /// \brief Sim time at which the solution diverged, -1 if never.
+      double divergenceTime = -1.0;
+
+      /// \brief True if the trials were not stopped early.
+      bool Completed() const
+      {
+        return this->overBudgetTime < 0 && this->divergenceTime < 0;
+      }
+    };
+  }
+}
+
+/////////////////////////////////////////////////
+// Set up the error statistics of a case, and the initial state of every
+// box with allBodyErrors.
+static void PrepareCase(const BoxesTrialSettings &_settings,
+                        const BoxesWorld &_boxes,
+                        BoxesCase &_case)
+{
+  const std::string statNames = "maxAbs";
+  EXPECT_TRUE(_case.linearPositionError.InsertStatistics(statNames));
+  EXPECT_TRUE(_case.linearVelocityError.InsertStatistics(statNames));
+  EXPECT_TRUE(_case.angularPositionError.InsertStatistics(statNames));
+  EXPECT_TRUE(_case.angularMomentumError.InsertStatistics(statNames));
+  EXPECT_TRUE(_case.energyError.InsertStatistics(statNames));
+
+  if (_settings.allBodyErrors)
+  {
+    _case.bodyErrors.Resize(_boxes.models.size());
+    for (size_t i = 0; i < _boxes.models.size(); ++i)
+    {
+      _case.links.push_back(_boxes.models[i]->GetLink());
+      _case.bodyErrors.SetInitialState(i,
+          _case.links[i]->WorldInertialPose().Pos(),
+          _case.links[i]->WorldCoGLinearVel(),
+          _case.links[i]->WorldAngularMomentum());
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+// Stop the trial once the errors of the tracked box exceed the
+// tolerances, or at the divergence check after step _step.
+static void CheckErrorLimits(const BoxesTrialSettings &_settings,
+                             const BoxesWorld &_boxes,
+                             const BoxState &_state,
+                             int _step,
+                             BoxesCase &_case)
+{
+  const double t = _state.t;
+  const ignition::math::Vector3d &g = _boxes.g;
+  if (_settings.ErrorBudget())
+  {
+    const double positionError =
+        (_state.p - (_boxes.p0 + _boxes.v0 * t + 0.5*g*t*t)).Length();
+    const double momentumError =
+        ((_state.H - _boxes.H0) / _boxes.H0mag).Length();
+    if ((_settings.linPositionTolerance > 0 &&
+         !(positionError <= _settings.linPositionTolerance)) ||
+        (_settings.angMomentumTolerance > 0 &&
+         !(momentumError <= _settings.angMomentumTolerance)))
+    {
+      _case.overBudgetTime = t;
+    }
+  }
+
+  if (_settings.divergenceThreshold > 0 &&
+      _step % _settings.divergenceInterval == 0)
+  {
+    const double energyDrift = std::abs((_state.E - _boxes.E0) / _boxes.E0);
+    const double momentumDrift =
+        ((_state.H - _boxes.H0) / _boxes.H0mag).Length();
+    if (!(energyDrift <= _settings.divergenceThreshold) ||
+        !(momentumDrift <= _settings.divergenceThreshold))
+    {
+      _case.divergenceTime = t;
+    }
   }
-  ignition::math::Vector3d g = world->Gravity();
+}
 
+/////////////////////////////////////////////////
+// Write the state of the tracked box after a step to the trajectory.
+static void WriteTrajectoryRow(const BoxState &_state, double _stepTime,
+                               physics::LinkPtr _link,
+                               TrajectoryWriter &_trajectory)
+{
+  const ignition::math::Vector3d &p = _state.p;
+  const ignition::math::Vector3d &v = _state.v;
+  const ignition::math::Vector3d &H = _state.H;
+  const ignition::math::Quaterniond q = _link->WorldInertialPose().Rot();
+  const ignition::math::Vector3d w = _link->WorldAngularVel();
+  const TrajectoryWriter::Row row = {{
+    _state.t, _stepTime,
+    p.X(), p.Y(), p.Z(), q.W(), q.X(), q.Y(), q.Z(),
+    v.X(), v.Y(), v.Z(), w.X(), w.Y(), w.Z(),
+    H.X(), H.Y(), H.Z(), _state.E}};
+  _trajectory.Write(row);
+}
+
+/////////////////////////////////////////////////
+void BoxesFixture::LoadBoxes(const std::string &_physicsEngine
+                           , int _modelCount
+                           , bool _collision
+                           , bool _complex
+                           , const BoxesOptions &_options
+                           , BoxesWorld &_boxes)
+{
   // Box size
-  const double dx = 0.1;
-  const double dy = 0.4;
-  const double dz = 0.9;
-  const double mass = 10.0;
-  // expected inertia matrix, recompute if the above change
-  const double Ixx = 0.80833333;
-  const double Iyy = 0.68333333;
-  const double Izz = 0.14166667;
+  const double dx = kBoxDx;
+  const double dy = kBoxDy;
+  const double dz = kBoxDz;
+  const double mass = kBoxMass;
+  // expected inertia matrix
+  const double Ixx = kBoxIxx;
+  const double Iyy = kBoxIyy;
+  const double Izz = kBoxIzz;
   const ignition::math::Matrix3d I0(Ixx, 0.0, 0.0
                                   , 0.0, Iyy, 0.0
                                   , 0.0, 0.0, Izz);
@@ -77,48 +423,93 @@ void BoxesTest::Boxes(const std::string &_physicsEngine
   }
 
   // spawn multiple boxes
-  // compute error statistics only on the last box
+  // compute detailed error statistics only on the last box,
+  // and optionally the maximum errors of every box
   ASSERT_GT(_modelCount, 0);
-  physics::ModelPtr model;
-  physics::LinkPtr link;
-
-  // initial linear velocity in global frame
-  ignition::math::Vector3d v0;
+  BoxInitialConditions(_complex, _boxes.v0, _boxes.w0, _boxes.E0);
+  const ignition::math::Vector3d &v0 = _boxes.v0;
+  const ignition::math::Vector3d &w0 = _boxes.w0;
 
-  // initial angular velocity in global frame
-  ignition::math::Vector3d w0;
+  // lattice pitch and positions, from the largest extent so that
+  // boxes do not start inside each other
+  const double pitch = _options.latticeSpacing * std::max({dx, dy, dz});
+  const auto lattice = LatticePositions(_modelCount, pitch);
+  this->Record("latticeSpacing", _options.latticeSpacing);
 
-  // initial energy value
-  double E0;
+  // give models unique names and positions
+  std::vector<msgs::Model> msgModels;
+  for (int i = 0; i < _modelCount; ++i)
+  {
+    msgModel.set_name(this->GetUniqueString("model"));
+    ignition::math::Vector3d position(0.0, dz*2*i, 0.0);
+    if (pitch > 0)
+    {
+      position = lattice[i];
+    }
+    msgs::Set(msgModel.mutable_pose()->mutable_position(), position);
+    msgModels.push_back(msgModel);
+  }
 
-  if (!_complex)
+  // Boxes are either loaded with the world from a single generated sdf
+  // file, or spawned one at a time into a blank world (no ground plane)
+  // with a factory message and wait per box.
+  // Headless worlds are always loaded from a generated sdf string.
+  const bool batchSpawn = _options.headless ||
+      OptionBool("BENCHMARK_BATCH_SPAWN", _options.batchSpawn);
+  RecordProperty("batchSpawn", batchSpawn);
+  RecordProperty("fixture", _options.headless ? "headless" : "server");
+  const common::Time spawnStartTime = common::Time::GetWallTime();
+  const double loadStartRss = ResidentSetSize();
+  physics::WorldPtr world;
+  if (batchSpawn)
   {
-    v0.Set(-0.9, 0.4, 0.1);
-    // Use angular velocity with one non-zero component
-    // to ensure linear angular trajectory
-    w0.Set(0.5, 0, 0);
-    E0 = 5.001041625;
+    WorldBuilder builder;
+    builder.AddModels(msgModels);
+    if (_options.headless)
+    {
+      builder.SetPhysicsEngine(_physicsEngine);
+      world = this->LoadHeadless(builder.ToString());
+    }
+    else
+    {
+      const std::string worldFile = builder.WriteTemporary("boxes");
+      ASSERT_FALSE(worldFile.empty());
+      Load(worldFile, true, _physicsEngine);
+      boost::filesystem::remove(worldFile);
+    }
   }
   else
   {
-    v0.Set(-2.0, 2.0, 8.0);
-    // Since Ixx > Iyy > Izz,
-    // angular velocity with large y component
-    // will cause gyroscopic tumbling
-    w0.Set(0.1, 5.0, 0.1);
-    E0 = 368.54641249999997;
+    Load("worlds/blank.world", true, _physicsEngine);
   }
+  if (!_options.headless)
+    world = physics::get_world("default");
+  ASSERT_NE(world, nullptr);
+  _boxes.world = world;
 
-  for (int i = 0; i < _modelCount; ++i)
+  // Verify physics engine type
+  physics::PhysicsEnginePtr physics = world->Physics();
+  ASSERT_NE(physics, nullptr);
+  ASSERT_EQ(physics->GetType(), _physicsEngine);
+  _boxes.physics = physics;
+
+  // get gravity value
+  if (!_complex)
   {
-    // give models unique names
-    msgModel.set_name(this->GetUniqueString("model"));
-    // give models unique positions
-    msgs::Set(msgModel.mutable_pose()->mutable_position(),
-              ignition::math::Vector3d(0.0, dz*2*i, 0.0));
+    world->SetGravity(ignition::math::Vector3d::Zero);
+  }
+  _boxes.g = world->Gravity();
 
-    model = this->SpawnModel(msgModel);
+  physics::LinkPtr link;
+  for (const auto &msg : msgModels)
+  {
+    physics::ModelPtr model;
+    if (batchSpawn)
+      model = world->ModelByName(msg.name());
+    else
+      model = this->SpawnModel(msg);
     ASSERT_NE(model, nullptr);
+    _boxes.models.push_back(model);
 
     link = model->GetLink();
     ASSERT_NE(link, nullptr);
@@ -127,29 +518,679 @@ void BoxesTest::Boxes(const std::string &_physicsEngine
     link->SetLinearVel(v0);
     link->SetAngularVel(w0);
   }
+  _boxes.link = link;
+  this->Record("spawnWallTime",
+      (common::Time::GetWallTime() - spawnStartTime).Double());
+
+  // Resident memory of the loaded world and boxes
+  const double spawnRssGrowth = ResidentSetSize() - loadStartRss;
+  this->Record("spawnRssGrowth", spawnRssGrowth);
+  this->Record("rssPerModel", spawnRssGrowth / _modelCount);
   ASSERT_EQ(v0, link->WorldCoGLinearVel());
   ASSERT_EQ(w0, link->WorldAngularVel());
   ASSERT_EQ(I0, link->GetInertial()->MOI());
-  ASSERT_NEAR(link->GetWorldEnergy(), E0, 1e-6);
-
-  // initial time
-  common::Time t0 = world->SimTime();
+  ASSERT_NEAR(link->GetWorldEnergy(), _boxes.E0, 1e-6);
 
   // initial linear position in global frame
-  ignition::math::Vector3d p0 = link->WorldInertialPose().Pos();
+  _boxes.p0 = link->WorldInertialPose().Pos();
 
   // initial angular momentum in global frame
-  ignition::math::Vector3d H0 = link->WorldAngularMomentum();
-  ASSERT_EQ(H0, ignition::math::Vector3d(Ixx, Iyy, Izz) * w0);
-  double H0mag = H0.Length();
+  _boxes.H0 = link->WorldAngularMomentum();
+  ASSERT_EQ(_boxes.H0, ignition::math::Vector3d(Ixx, Iyy, Izz) * w0);
+  _boxes.H0mag = _boxes.H0.Length();
 
-  // change step size after setting initial conditions
-  // since simbody requires a time step
-  physics->SetMaxStepSize(_dt);
-  const double simDuration = 10.0;
-  int steps = ceil(simDuration / _dt);
+  _boxes.snapshot.Capture(world);
+}
+
+/////////////////////////////////////////////////
+void BoxesFixture::ReadTrialSettings(const BoxesOptions &_options
+                                   , BoxesTrialSettings &_settings)
+{
+  // Untimed warm-up steps and number of timed trials.
+  // Each trial after a warm-up or previous trial restarts
+  // from the same initial state.
+  _settings.warmupSteps =
+      std::max(0, OptionInt("BENCHMARK_WARMUP_STEPS", 0));
+  _settings.trials = std::max(1, OptionInt("BENCHMARK_TRIALS", 1));
+  this->Record("warmupSteps", _settings.warmupSteps);
+  this->Record("trials", _settings.trials);
+  _settings.allBodyErrors =
+      OptionBool("BENCHMARK_ALL_BODY_ERRORS", _options.allBodyErrors);
+  RecordProperty("allBodyErrors", _settings.allBodyErrors);
+  _settings.asyncAnalysis = OptionBool("BENCHMARK_ASYNC_ANALYSIS", true);
+  RecordProperty("asyncAnalysis", _settings.asyncAnalysis);
+
+  // Precision of the stored state of every box (pose and velocities),
+  // and a label for runs against an engine built in single precision
+  // (such as ODE with dSINGLE), to compare both with compare_results.py.
+  _settings.float32State =
+      OptionBool("BENCHMARK_FLOAT32_STATE", _options.float32State);
+  RecordProperty("statePrecision",
+      _settings.float32State ? "float32" : "float64");
+  RecordProperty("enginePrecision",
+      OptionString("BENCHMARK_ENGINE_PRECISION", "double"));
+
+  // Trials are aborted once the errors of the tracked box exceed
+  // the tolerances, which also drive the time step size search.
+  _settings.linPositionTolerance = OptionDouble(
+      "BENCHMARK_LIN_POSITION_TOLERANCE", _options.linPositionTolerance);
+  _settings.angMomentumTolerance = OptionDouble(
+      "BENCHMARK_ANG_MOMENTUM_TOLERANCE", _options.angMomentumTolerance);
+  if (_settings.ErrorBudget())
+  {
+    this->Record("linPositionTolerance", _settings.linPositionTolerance);
+    this->Record("angMomentumTolerance", _settings.angMomentumTolerance);
+  }
+
+  // Trials are also stopped when the solution diverges
+  _settings.divergenceThreshold = OptionDouble(
+      "BENCHMARK_DIVERGENCE_THRESHOLD", _options.divergenceThreshold);
+  _settings.divergenceInterval = std::max(1,
+      OptionInt("BENCHMARK_DIVERGENCE_INTERVAL", _options.divergenceInterval));
+  if (_settings.divergenceThreshold > 0)
+    this->Record("divergenceThreshold", _settings.divergenceThreshold);
+}
+
+/////////////////////////////////////////////////
+bool BoxesFixture::OpenPerfCounters(BoxesWorld &_boxes
+                                  , PerfCounters &_counters)
+{
+  // The id of the world update thread is known after its first update.
+  bool perfCounters = OptionBool("BENCHMARK_PERF_COUNTERS", false);
+  if (perfCounters)
+  {
+    if (this->PhysicsThreadId() == 0)
+    {
+      this->StepWorld(_boxes.world, 1);
+      _boxes.snapshot.Restore(_boxes.world);
+    }
+    perfCounters = _counters.Open(this->PhysicsThreadId());
+    if (!perfCounters)
+      gzwarn << "Performance counters are unavailable" << std::endl;
+  }
+  RecordProperty("perfCounters", perfCounters);
+  return perfCounters;
+}
+
+/////////////////////////////////////////////////
+void BoxesFixture::SetSolverSettings(const std::string &_physicsEngine
+                                   , const SolverSettings &_solver
+                                   , BoxesWorld &_boxes)
+{
+  bool supported = true;
+  if (_solver.iterations > 0)
+  {
+    supported =
+        _boxes.physics->SetParam("iters", _solver.iterations) && supported;
+  }
+  if (_solver.sor > 0)
+    supported = _boxes.physics->SetParam("sor", _solver.sor) && supported;
+  this->Record("iters", _solver.iterations);
+  this->Record("sor", _solver.sor);
+  RecordProperty("solverSupported", supported);
+  if (!supported)
+  {
+    gzwarn << "Physics engine [" << _physicsEngine
+           << "] does not support the iterative solver settings"
+           << std::endl;
+  }
+}
+
+/////////////////////////////////////////////////
+double BoxesFixture::ParallelBaseline(const std::string &_physicsEngine
+                                    , const BoxesOptions &_options
+                                    , int _steps
+                                    , bool _restore
+                                    , bool _resetParams
+                                    , BoxesWorld &_boxes)
+{
+  physics::PhysicsEnginePtr physics = _boxes.physics;
+
+  // engine defaults for the baseline of later sweep cases
+  if (_resetParams)
+  {
+    physics->SetParam("island_threads", 0);
+    physics->SetParam("thread_position_correction", false);
+  }
+  if (_restore)
+    _boxes.snapshot.Restore(_boxes.world);
+  StepTimer baselineTimer;
+  for (int i = 0; i < _steps; ++i)
+  {
+    baselineTimer.Start();
+    this->StepWorld(_boxes.world, 1);
+    baselineTimer.Stop();
+  }
+
+  bool supported =
+      physics->SetParam("island_threads", _options.islandThreads);
+  supported = supported && physics->SetParam("thread_position_correction",
+      _options.threadPositionCorrection);
+  RecordProperty("parallelSupported", supported);
+  if (!supported)
+  {
+    gzwarn << "Physics engine [" << _physicsEngine
+           << "] does not support island threads" << std::endl;
+  }
+  return baselineTimer.Total();
+}
+
+/////////////////////////////////////////////////
+void BoxesFixture::OpenTrajectory(
+    const std::map<std::string, std::string> &_params
+  , const std::string &_suffix
+  , int _steps
+  , BoxesCase &_case)
+{
+  const std::string trajectoryDir = OptionString("BENCHMARK_TRAJECTORY_DIR");
+  if (trajectoryDir.empty())
+    return;
+
+  const std::vector<std::string> columns = {
+    "t", "stepTime",
+    "px", "py", "pz", "qw", "qx", "qy", "qz",
+    "vx", "vy", "vz", "wx", "wy", "wz",
+    "Hx", "Hy", "Hz", "energy"};
+  const std::string filename = trajectoryDir + "/" +
+      this->TestFileName() + _suffix + ".traj";
+  if (_case.trajectory.Open(filename, columns, _steps, _params))
+    RecordProperty("trajectoryFile", filename);
+}
+
+/////////////////////////////////////////////////
+void BoxesFixture::RunTrials(const BoxesTrialSettings &_settings
+                           , bool _complex
+                           , int _steps
+                           , double _simDuration
+                           , bool _restore
+                           , BoxesWorld &_boxes
+                           , PerfCounters &_counters
+                           , BoxesCase &_case)
+{
+  typedef StepTimer::Clock clock;
+  physics::WorldPtr world = _boxes.world;
+  physics::LinkPtr link = _boxes.link;
+  const ignition::math::Vector3d &v0 = _boxes.v0;
+  const ignition::math::Vector3d &w0 = _boxes.w0;
+  const ignition::math::Vector3d &g = _boxes.g;
+  const ignition::math::Vector3d &p0 = _boxes.p0;
+  const ignition::math::Vector3d &H0 = _boxes.H0;
+  const double H0mag = _boxes.H0mag;
+  const double E0 = _boxes.E0;
+
+  // Hashes of the world state every replayInterval steps of the first
+  // trial, to compare the trajectory with a reference run
+  const int replayInterval = this->ReplayInterval();
+
+  // Running maximum errors of the tracked box in the live telemetry,
+  // raised by the analysis with a compare and swap loop
+  Telemetry &telemetry = LiveTelemetry();
+  std::atomic<double> &liveLinPositionErr =
+      telemetry.Gauge("linPositionErrMaxAbs");
+  std::atomic<double> &liveAngMomentumErr =
+      telemetry.Gauge("angMomentumErrMaxAbs");
+  std::atomic<double> &liveEnergyErr = telemetry.Gauge("energyErrMaxAbs");
+  liveLinPositionErr.store(0.0, std::memory_order_relaxed);
+  liveAngMomentumErr.store(0.0, std::memory_order_relaxed);
+  liveEnergyErr.store(0.0, std::memory_order_relaxed);
+  auto liveMax = [](std::atomic<double> &_gauge, double _value)
+  {
+    double current = _gauge.load(std::memory_order_relaxed);
+    while (_value > current &&
+           !_gauge.compare_exchange_weak(current, _value,
+               std::memory_order_relaxed))
+    {
+    }
+  };
+
+  // Error statistics of the tracked box are updated by a worker thread
+  // that overlaps with the next steps, or inline when disabled.
+  auto analyze = [&](const BoxState &_state)
+  {
+    const double t = _state.t;
+    _case.linearVelocityError.InsertData(_state.v - (v0 + g*t));
+    _case.linearPositionError.InsertData(
+        _state.p - (p0 + v0 * t + 0.5*g*t*t));
+    _case.angularMomentumError.InsertData((_state.H - H0) / H0mag);
+    if (!_complex)
+    {
+      ignition::math::Quaterniond angleTrue(w0 * t);
+      _case.angularPositionError.InsertData(_state.a - angleTrue.Euler());
+    }
+    _case.energyError.InsertData((_state.E - E0) / E0);
+    liveMax(liveLinPositionErr,
+        (_state.p - (p0 + v0 * t + 0.5*g*t*t)).Length());
+    liveMax(liveAngMomentumErr, ((_state.H - H0) / H0mag).Length());
+    liveMax(liveEnergyErr, std::abs((_state.E - E0) / E0));
+  };
+  StepObserver<BoxState> observer(4096, analyze);
+  if (_settings.asyncAnalysis)
+    observer.Start();
+
+  _case.memory.Start();
+  _counters.Start();
+  for (int trial = 0; trial < _settings.trials; ++trial)
+  {
+    if (_restore || trial > 0)
+    {
+      _boxes.snapshot.Restore(world);
+    }
+
+    // initial time
+    common::Time t0 = world->SimTime();
+
+    common::Time startTime = common::Time::GetWallTime();
+    for (int i = 0; i < _steps; ++i)
+    {
+      _case.stepTimer.Start();
+      this->StepWorld(world, 1);
+      const double stepTime = _case.stepTimer.Stop();
+      if (_settings.float32State)
+      {
+        for (const auto &m : _boxes.models)
+          RoundStateToFloat(m->GetLink());
+      }
+      const clock::time_point analysisStart = clock::now();
 
-  // variables to compute statistics on
+      // Gather the state of the tracked box, analyzed by the observer
+      BoxState state;
+      state.t = (world->SimTime() - t0).Double();
+      state.p = link->WorldInertialPose().Pos();
+      state.v = link->WorldCoGLinearVel();
+      state.H = link->WorldAngularMomentum();
+      if (!_complex)
+        state.a = link->WorldInertialPose().Rot().Euler();
+      state.E = link->GetWorldEnergy();
+      observer.Publish(state);
+      if (replayInterval > 0 && trial == 0 &&
+          (i + 1) % replayInterval == 0)
+      {
+        _case.replay.Add(i + 1, world);
+      }
+
+      CheckErrorLimits(_settings, _boxes, state, i + 1, _case);
+
+      if (trial == 0 && _case.trajectory.IsOpen())
+        WriteTrajectoryRow(state, stepTime, link, _case.trajectory);
+
+      const clock::time_point allBodyStart = clock::now();
+      _case.analysisDuration += allBodyStart - analysisStart;
+
+      if (_settings.allBodyErrors)
+      {
+        for (size_t j = 0; j < _case.links.size(); ++j)
+        {
+          _case.bodyErrors.SetState(j,
+              _case.links[j]->WorldInertialPose().Pos(),
+              _case.links[j]->WorldCoGLinearVel(),
+              _case.links[j]->WorldAngularMomentum());
+        }
+        _case.bodyErrors.Update(state.t, g);
+        _case.allBodyDuration += clock::now() - allBodyStart;
+      }
+
+      if (!_case.Completed())
+        break;
+    }
+    common::Time elapsedTime = common::Time::GetWallTime() - startTime;
+    if (trial == 0 && _case.trajectory.IsOpen())
+    {
+      EXPECT_TRUE(_case.trajectory.Close());
+      this->Record("trajectoryStalls",
+          static_cast<double>(_case.trajectory.Stalls()));
+    }
+    _case.simTime = world->SimTime() - t0;
+    _case.wallTimes.Insert(elapsedTime.Double());
+    _case.timeRatios.Insert(elapsedTime.Double() / _case.simTime.Double());
+
+    // the remaining trials would exceed the tolerances as well
+    if (!_case.Completed())
+      break;
+    ASSERT_NEAR(_case.simTime.Double(), _simDuration,
+        _boxes.physics->GetMaxStepSize()*1.1);
+  }
+  _counters.Stop();
+  _case.memory.Stop(_case.stepTimer.Count());
+  observer.Stop();
+  if (_settings.asyncAnalysis)
+    this->Record("observerStalls", static_cast<double>(observer.Stalls()));
+}
+
+/////////////////////////////////////////////////
+double BoxesFixture::RecordCaseTimes(const BoxesTrialSettings &_settings
+                                   , int _modelCount
+                                   , const BoxesCase &_case
+                                   , const PerfCounters &_counters)
+{
+  const unsigned int trialsRun = _case.wallTimes.Count();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  this->Record("trialsRun", trialsRun);
+  this->Record("simTime", _case.simTime.Double());
+  this->Record("", _case.memory);
+
+  // Rounding the state of a double precision engine adds work to every
+  // step without making the engine faster, so the timings of a float32
+  // state run do not measure single precision throughput and only its
+  // accuracy is recorded.
+  if (_settings.float32State)
+    return nan;
+
+  // wallTime and timeRatio are averaged over the trials, and are NaN
+  // for a case that stopped early, whose partial run is not comparable
+  const bool stoppedEarly = !_case.Completed();
+  this->Record("wallTime", stoppedEarly ? nan : _case.wallTimes.Mean());
+  this->Record("timeRatio", stoppedEarly ? nan : _case.timeRatios.Mean());
+  this->Record("wallTime_", _case.wallTimes);
+  this->Record("timeRatio_", _case.timeRatios);
+  if (_settings.perfCounters)
+    this->Record("", _counters, _case.stepTimer.Count());
+
+  // Record physics-only step time and error analysis time per trial
+  const StepTimer &stepTimer = _case.stepTimer;
+  this->Record("stepWallTime",
+      stoppedEarly ? nan : stepTimer.Total() / trialsRun);
+  this->Record("stepTimeRatio", stoppedEarly ? nan :
+      stepTimer.Total() / trialsRun / _case.simTime.Double());
+  this->Record("analysisWallTime",
+      std::chrono::duration<double>(_case.analysisDuration).count() /
+      trialsRun);
+  this->Record("stepLatency_", stepTimer);
+  const double bodyStepsPerSecond = static_cast<double>(_modelCount) *
+      stepTimer.Count() / stepTimer.Total();
+  this->Record("bodyStepsPerSecond", bodyStepsPerSecond);
+  return bodyStepsPerSecond;
+}
+
+/////////////////////////////////////////////////
+void BoxesFixture::RecordReferenceError(
+    size_t _dtCase
+  , bool _completed
+  , const BoxesWorld &_boxes
+  , std::vector<ignition::math::Vector3d> &_referencePositions)
+{
+  // Final positions of all boxes relative to the reference case,
+  // NaN when this case or the reference stopped early
+  std::vector<ignition::math::Vector3d> positions;
+  for (const auto &m : _boxes.models)
+    positions.push_back(m->GetLink()->WorldInertialPose().Pos());
+  if (_dtCase == 0)
+  {
+    EXPECT_TRUE(_completed) << "reference case stopped early";
+    if (_completed)
+      _referencePositions = positions;
+  }
+  double maxError = std::numeric_limits<double>::quiet_NaN();
+  double meanError = std::numeric_limits<double>::quiet_NaN();
+  if (_completed && !_referencePositions.empty())
+  {
+    maxError = 0.0;
+    double sumError = 0.0;
+    for (size_t j = 0; j < positions.size(); ++j)
+    {
+      const double error =
+          (positions[j] - _referencePositions[j]).Length();
+      maxError = std::max(maxError, error);
+      sumError += error;
+    }
+    meanError = sumError / positions.size();
+  }
+  this->Record("refPositionErr_max", maxError);
+  this->Record("refPositionErr_mean", meanError);
+}
+
+/////////////////////////////////////////////////
+void BoxesFixture::RecordCaseErrors(const BoxesTrialSettings &_settings
+                                  , const BoxesWorld &_boxes
+                                  , BoxesCase &_case)
+{
+  // Record statistics on pitch and yaw angles
+  this->Record("energy0", _boxes.E0);
+  this->Record("energyError_", _case.energyError);
+  this->Record("angMomentum0", _boxes.H0mag);
+  this->Record("angMomentumErr_", _case.angularMomentumError.Mag());
+  this->Record("angPositionErr", _case.angularPositionError);
+  this->Record("linPositionErr_", _case.linearPositionError.Mag());
+  this->Record("linVelocityErr_", _case.linearVelocityError.Mag());
+
+  // Maximum errors of the worst box and mean of the per-box maximum errors
+  if (_settings.allBodyErrors)
+  {
+    const BodyErrors &bodyErrors = _case.bodyErrors;
+    this->Record("allBodyWallTime",
+        std::chrono::duration<double>(_case.allBodyDuration).count() /
+        _case.wallTimes.Count());
+    this->Record("allAngMomentumErr_maxAbs", bodyErrors.MaxMomentumError());
+    this->Record("allAngMomentumErr_meanMaxAbs",
+        bodyErrors.MeanMomentumError());
+    this->Record("allLinPositionErr_maxAbs", bodyErrors.MaxPositionError());
+    this->Record("allLinPositionErr_meanMaxAbs",
+        bodyErrors.MeanPositionError());
+    this->Record("allLinVelocityErr_maxAbs", bodyErrors.MaxVelocityError());
+    this->Record("allLinVelocityErr_meanMaxAbs",
+        bodyErrors.MeanVelocityError());
+    this->Record("allWorstBody", static_cast<double>(bodyErrors.WorstBody()));
+  }
+}
+
+/////////////////////////////////////////////////
+// Boxes:
+// Spawn a single box and record accuracy for momentum and enery
+// conservation
+void BoxesFixture::Boxes(const std::string &_physicsEngine
+                       , double _dt
+                       , int _modelCount
+                       , bool _collision
+                       , bool _complex
+                       , const BoxesOptions &_options)
+{
+  BoxesWorld boxes;
+  ASSERT_NO_FATAL_FAILURE(this->LoadBoxes(_physicsEngine, _modelCount,
+      _collision, _complex, _options, boxes));
+  physics::PhysicsEnginePtr physics = boxes.physics;
+
+  BoxesTrialSettings settings;
+  this->ReadTrialSettings(_options, settings);
+
+  // Optional performance counters of the world update thread
+  PerfCounters counters;
+  settings.perfCounters = this->OpenPerfCounters(boxes, counters);
+
+  // Test parameters in the header of the trajectory files
+  std::map<std::string, std::string> trajectoryParams;
+  trajectoryParams["engine"] = _physicsEngine;
+  trajectoryParams["modelCount"] = std::to_string(_modelCount);
+  trajectoryParams["collision"] = std::to_string(_collision);
+  trajectoryParams["isComplex"] = std::to_string(_complex);
+  trajectoryParams["latticeSpacing"] =
+      std::to_string(_options.latticeSpacing);
+  trajectoryParams["energy0"] = std::to_string(boxes.E0);
+
+  // With a dt sweep or search, each time step size is recorded
+  // as a separate case
+  const bool search = _options.dtSearchMax > 0;
+  DtSearch dtSearch(_options.dtSearchMin, _options.dtSearchMax,
+      _options.dtSearchIterations);
+  const bool sweep = search || !_options.dtSweep.empty();
+  const std::vector<double> dts = _options.dtSweep.empty() ?
+      std::vector<double>(1, _dt) : _options.dtSweep;
+  std::map<double, std::pair<double, double>> throughputs;
+  const bool solverSweep = !_options.solverSweep.empty();
+  ASSERT_TRUE(!solverSweep ||
+      _options.solverSweep.size() == _options.dtSweep.size());
+  std::vector<ignition::math::Vector3d> referencePositions;
+  size_t dtCase = 0;
+  for (; search ? !dtSearch.Done() : dtCase < dts.size(); ++dtCase)
+  {
+    const double dt = search ? dtSearch.Current() : dts[dtCase];
+    const std::string caseSuffix =
+        sweep ? "_dt" + std::to_string(dtCase) : std::string();
+    if (sweep)
+    {
+      this->SetRecordCase(dtCase);
+      this->Record("dt", dt);
+      if (dtCase > 0)
+        boxes.snapshot.Restore(boxes.world);
+    }
+
+    // Iterative solver settings of this case
+    if (solverSweep)
+    {
+      this->SetSolverSettings(_physicsEngine, _options.solverSweep[dtCase],
+          boxes);
+    }
+
+    // change step size after setting initial conditions
+    // since simbody requires a time step
+    physics->SetMaxStepSize(dt);
+    const int steps = ceil(_options.simDuration / dt);
+
+    BoxesCase boxesCase;
+    PrepareCase(settings, boxes, boxesCase);
+
+    // unthrottle update rate
+    physics->SetRealTimeUpdateRate(0.0);
+    if (settings.warmupSteps > 0)
+    {
+      this->StepWorld(boxes.world, settings.warmupSteps);
+    }
+
+    // Parallel solver settings. The step time with the engine defaults is
+    // measured first, to compute the speedup of the parallel settings.
+    const bool parallel =
+        _options.islandThreads > 0 || _options.threadPositionCorrection;
+    bool needsReset = settings.warmupSteps > 0;
+    double baselineStepWallTime = 0.0;
+    if (parallel)
+    {
+      baselineStepWallTime = this->ParallelBaseline(_physicsEngine,
+          _options, steps, needsReset, dtCase > 0, boxes);
+      needsReset = true;
+    }
+    RecordProperty("islandThreads", _options.islandThreads);
+    RecordProperty("threadPositionCorrection",
+        _options.threadPositionCorrection);
+
+    // Optionally stream the state of the tracked box at every step of
+    // the first trial to a binary file, written by a background thread.
+    trajectoryParams["dt"] = std::to_string(dt);
+    this->OpenTrajectory(trajectoryParams, caseSuffix, steps, boxesCase);
+
+    LiveTelemetry().SetInfo("dt", std::to_string(dt));
+    boxesCase.replay = this->NewReplayLog();
+    ASSERT_NO_FATAL_FAILURE(this->RunTrials(settings, _complex, steps,
+        _options.simDuration, needsReset, boxes, counters, boxesCase));
+    if (this->ReplayInterval() > 0)
+      this->FinishReplay(boxesCase.replay, caseSuffix);
+
+    const double bodyStepsPerSecond =
+        this->RecordCaseTimes(settings, _modelCount, boxesCase, counters);
+    if (parallel && !settings.float32State)
+    {
+      const double speedup = baselineStepWallTime /
+          (boxesCase.stepTimer.Total() / boxesCase.wallTimes.Count());
+      this->Record("baselineStepWallTime", baselineStepWallTime);
+      this->Record("speedup", speedup);
+      this->Record("parallelEfficiency",
+          speedup / std::max(1, _options.islandThreads));
+    }
+
+    this->RecordProfile();
+
+    if (settings.ErrorBudget())
+    {
+      this->Record("overBudget", boxesCase.overBudgetTime >= 0);
+      this->Record("overBudgetTime", boxesCase.overBudgetTime);
+    }
+    if (settings.divergenceThreshold > 0)
+    {
+      this->Record("diverged", boxesCase.divergenceTime >= 0);
+      this->Record("divergenceTime", boxesCase.divergenceTime);
+    }
+    if (solverSweep)
+    {
+      this->RecordReferenceError(dtCase, boxesCase.Completed(), boxes,
+          referencePositions);
+    }
+    if (search)
+    {
+      dtSearch.Report(boxesCase.Completed());
+      // bodyStepsPerSecond is NaN when the timings are not recorded
+      throughputs[dt] = std::make_pair(std::isnan(bodyStepsPerSecond) ?
+          bodyStepsPerSecond : boxesCase.timeRatios.Mean(),
+          bodyStepsPerSecond);
+    }
+
+    this->RecordCaseErrors(settings, boxes, boxesCase);
+  }
+  // Only sweeps and searches report their number of cases, so the
+  // columns of the single time step size tests are unchanged
+  if (sweep)
+  {
+    this->SetRecordCase(-1);
+    this->Record("sweepCases", dtCase);
+  }
+
+  // Largest time step size within the tolerances and its throughput
+  if (search)
+  {
+    const double dtChosen = dtSearch.Best();
+    this->Record("dtChosen", dtChosen);
+    if (dtChosen > 0)
+    {
+      this->Record("dtChosenTimeRatio", throughputs[dtChosen].first);
+      this->Record("dtChosenBodyStepsPerSecond", throughputs[dtChosen].second);
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+// Boxes external:
+// Run the boxes problem without collision shapes on an external backend
+// and record the same timing and error statistics as Boxes
+void BoxesFixture::BoxesExternal(const std::string &_backend
+                               , double _dt
+                               , int _modelCount
+                               , bool _complex)
+{
+  ASSERT_GT(_modelCount, 0);
+  std::string error;
+  BoxesBackendPtr backend = LoadBoxesBackend(_backend, error);
+  ASSERT_NE(backend, nullptr) << "Unable to load backend [" << _backend
+                              << "]: " << error;
+  RecordProperty("backend", backend->Name());
+
+  ignition::math::Vector3d v0;
+  ignition::math::Vector3d w0;
+  double E0;
+  BoxInitialConditions(_complex, v0, w0, E0);
+  const ignition::math::Vector3d g = _complex ?
+      ignition::math::Vector3d(0, 0, -9.8) : ignition::math::Vector3d::Zero;
+  const ignition::math::Vector3d I(kBoxIxx, kBoxIyy, kBoxIzz);
+
+  // Same initial positions as the boxes spawned along a line by Boxes
+  auto toBackend = [](const ignition::math::Vector3d &_v)
+  {
+    return BackendVector{{_v.X(), _v.Y(), _v.Z()}};
+  };
+  BoxesProblem problem;
+  problem.modelCount = _modelCount;
+  problem.dt = _dt;
+  problem.size = {{kBoxDx, kBoxDy, kBoxDz}};
+  problem.mass = kBoxMass;
+  problem.inertia = toBackend(I);
+  problem.gravity = toBackend(g);
+  problem.linearVel = toBackend(v0);
+  problem.angularVel = toBackend(w0);
+  for (int i = 0; i < _modelCount; ++i)
+    problem.positions.push_back({{0.0, kBoxDz*2*i, 0.0}});
+  ASSERT_TRUE(backend->Load(problem));
+
+  // Errors of the last box, as in Boxes
+  const int tracked = _modelCount - 1;
+  const ignition::math::Vector3d p0 =
+      ignition::math::Vector3d(0.0, kBoxDz*2*tracked, 0.0);
+  const ignition::math::Vector3d H0 = I * w0;
+  const double H0mag = H0.Length();
   ignition::math::Vector3Stats linearPositionError;
   ignition::math::Vector3Stats linearVelocityError;
   ignition::math::Vector3Stats angularPositionError;
@@ -164,47 +1205,68 @@ void BoxesTest::Boxes(const std::string &_physicsEngine
     EXPECT_TRUE(energyError.InsertStatistics(statNames));
   }
 
-  // unthrottle update rate
-  physics->SetRealTimeUpdateRate(0.0);
-  common::Time startTime = common::Time::GetWallTime();
+  // Step one step at a time and read back the tracked box after each
+  const double simDuration = 10.0;
+  const int steps = ceil(simDuration / _dt);
+  StepTimer stepTimer;
+  BoxesBodyState state;
+  const common::Time startTime = common::Time::GetWallTime();
   for (int i = 0; i < steps; ++i)
   {
-    world->Step(1);
+    stepTimer.Start();
+    ASSERT_TRUE(backend->Step(1));
+    stepTimer.Stop();
 
-    // current time
-    double t = (world->SimTime() - t0).Double();
+    backend->State(tracked, state);
+    const double t = (i + 1) * _dt;
+    const ignition::math::Vector3d p(
+        state.position[0], state.position[1], state.position[2]);
+    const ignition::math::Vector3d v(
+        state.linearVel[0], state.linearVel[1], state.linearVel[2]);
+    const ignition::math::Vector3d w(
+        state.angularVel[0], state.angularVel[1], state.angularVel[2]);
+    const ignition::math::Quaterniond q(state.orientation[0],
+        state.orientation[1], state.orientation[2], state.orientation[3]);
 
-    // linear velocity error
-    ignition::math::Vector3d v = link->WorldCoGLinearVel();
-    linearVelocityError.InsertData(v - (v0 + g*t));
+    // world angular momentum R I R^T w and energy
+    const ignition::math::Vector3d H = q.RotateVector(
+        I * q.RotateVectorReverse(w));
+    const double E = 0.5 * kBoxMass * v.Dot(v) + 0.5 * w.Dot(H)
+                   - kBoxMass * g.Dot(p);
 
-    // linear position error
-    ignition::math::Vector3d p = link->WorldInertialPose().Pos();
+    linearVelocityError.InsertData(v - (v0 + g*t));
     linearPositionError.InsertData(p - (p0 + v0 * t + 0.5*g*t*t));
-
-    // angular momentum error
-    ignition::math::Vector3d H = link->WorldAngularMomentum();
     angularMomentumError.InsertData((H - H0) / H0mag);
-
-    // angular position error
     if (!_complex)
     {
-      ignition::math::Vector3d a = link->WorldInertialPose().Rot().Euler();
       ignition::math::Quaterniond angleTrue(w0 * t);
-      angularPositionError.InsertData(a - angleTrue.Euler());
+      angularPositionError.InsertData(q.Euler() - angleTrue.Euler());
     }
-
-    // energy error
-    energyError.InsertData((link->GetWorldEnergy() - E0) / E0);
+    energyError.InsertData((E - E0) / E0);
   }
-  common::Time elapsedTime = common::Time::GetWallTime() - startTime;
-  this->Record("wallTime", elapsedTime.Double());
-  common::Time simTime = (world->SimTime() - t0).Double();
-  ASSERT_NEAR(simTime.Double(), simDuration, _dt*1.1);
-  this->Record("simTime", simTime.Double());
-  this->Record("timeRatio", elapsedTime.Double() / simTime.Double());
+  const double wallTime = (common::Time::GetWallTime() - startTime).Double();
+  const double simTime = steps * _dt;
+
+  // All steps in one call, as for batched rollouts that do not read the
+  // state back after every step
+  ASSERT_TRUE(backend->Load(problem));
+  StepTimer batchTimer;
+  batchTimer.Start();
+  ASSERT_TRUE(backend->Step(steps));
+  batchTimer.Stop();
+
+  this->Record("wallTime", wallTime);
+  this->Record("simTime", simTime);
+  this->Record("timeRatio", wallTime / simTime);
+  this->Record("stepWallTime", stepTimer.Total());
+  this->Record("stepTimeRatio", stepTimer.Total() / simTime);
+  this->Record("stepLatency_", stepTimer);
+  this->Record("bodyStepsPerSecond",
+      static_cast<double>(_modelCount) * steps / stepTimer.Total());
+  this->Record("batchWallTime", batchTimer.Total());
+  this->Record("batchBodyStepsPerSecond",
+      static_cast<double>(_modelCount) * steps / batchTimer.Total());
 
-  // Record statistics on pitch and yaw angles
   this->Record("energy0", E0);
   this->Record("energyError_", energyError);
   this->Record("angMomentum0", H0mag);
@@ -214,28 +1276,424 @@ void BoxesTest::Boxes(const std::string &_physicsEngine
   this->Record("linVelocityErr_", linearVelocityError.Mag());
 }
 
+/////////////////////////////////////////////////
+// Boxes pile:
+// Rest boxes on a ground plane in stacks, or drop them into piles, and
+// time the steps once they have settled, with every box in contact
+void BoxesFixture::BoxesPile(const std::string &_physicsEngine
+                           , double _dt
+                           , int _modelCount
+                           , bool _stacked)
+{
+  ASSERT_GT(_modelCount, 0);
+  msgs::Model msgModel;
+  msgs::AddBoxLink(msgModel, kBoxMass,
+      ignition::math::Vector3d(kBoxDx, kBoxDy, kBoxDz));
+
+  // Stacks are columns of stackHeight boxes lying on their largest face,
+  // with small gaps between levels so they start out of contact, and
+  // piles are tilted boxes on a lattice 1m above the ground that land on
+  // top of each other.
+  const int stackHeight = 8;
+  const int columns = (_modelCount + stackHeight - 1) / stackHeight;
+  const int edge = std::ceil(std::sqrt(columns) - 1e-9);
+  const auto lattice = LatticePositions(_modelCount,
+      ignition::math::Vector3d(kBoxDx, kBoxDy, kBoxDz).Length());
+  std::vector<msgs::Model> msgModels;
+  for (int i = 0; i < _modelCount; ++i)
+  {
+    ignition::math::Pose3d pose;
+    if (_stacked)
+    {
+      const int column = i / stackHeight;
+      const int level = i % stackHeight;
+      pose.Set(1.2 * (column % edge), 0.6 * (column / edge),
+               (kBoxDx + 1e-3) * (level + 0.5), 0, M_PI / 2, 0);
+    }
+    else
+    {
+      pose.Set(lattice[i] + ignition::math::Vector3d(0, 0, 1.0),
+               ignition::math::Quaterniond(0.3 * i, 0.7 * i, 1.1 * i));
+    }
+    msgModel.set_name("box_" + std::to_string(i));
+    msgs::Set(msgModel.mutable_pose(), pose);
+    msgModels.push_back(msgModel);
+  }
+  RecordProperty("layout", _stacked ? "stacked" : "pile");
+  this->Record("stackHeight", _stacked ? stackHeight : 0);
+
+  WorldBuilder builder;
+  builder.AddInclude("model://ground_plane");
+  builder.AddModels(msgModels);
+  const std::string worldFile = builder.WriteTemporary("boxes_pile");
+  ASSERT_FALSE(worldFile.empty());
+  Load(worldFile, true, _physicsEngine);
+  boost::filesystem::remove(worldFile);
+  physics::WorldPtr world = physics::get_world("default");
+  ASSERT_NE(world, nullptr);
+
+  // Verify physics engine type
+  physics::PhysicsEnginePtr physics = world->Physics();
+  ASSERT_NE(physics, nullptr);
+  ASSERT_EQ(physics->GetType(), _physicsEngine);
+  physics->SetMaxStepSize(_dt);
+  physics->SetRealTimeUpdateRate(0.0);
+
+  std::vector<physics::LinkPtr> links;
+  for (const auto &msg : msgModels)
+  {
+    physics::ModelPtr model = world->ModelByName(msg.name());
+    ASSERT_NE(model, nullptr);
+    physics::LinkPtr link = model->GetLink();
+    ASSERT_NE(link, nullptr);
+    links.push_back(link);
+  }
+  auto maxSpeed = [&links]()
+  {
+    double speed = 0.0;
+    for (const auto &link : links)
+      speed = std::max(speed, link->WorldCoGLinearVel().Length());
+    return speed;
+  };
+
+  auto contactSub = this->node->Subscribe("~/physics/contacts",
+      &OnPileContacts);
+  physics::ContactManager *contactManager = physics->GetContactManager();
+
+  // Settle until the fastest box is slower than settleSpeed at
+  // settleChecks consecutive checks, 10 steps apart, and not before
+  // minSettleTime, the fall time of the highest box plus 0.5 s, so that
+  // boxes momentarily at rest at the top of a fall or bounce are not
+  // taken as settled.
+  const double settleSpeed = 0.05;
+  const int settleChecks = 10;
+  const double settleDuration = 5.0;
+  double maxHeight = 0.0;
+  for (const auto &msg : msgModels)
+    maxHeight = std::max(maxHeight, msgs::ConvertIgn(msg.pose()).Pos().Z());
+  const double gravity = world->Gravity().Length();
+  const double minSettleTime = 0.5 +
+      (gravity > 0 ? std::sqrt(2.0 * maxHeight / gravity) : 0.0);
+  const int minSettleSteps = ceil(minSettleTime / _dt);
+  const int settleSteps = ceil(settleDuration / _dt);
+  int settledSteps = 0;
+  int slowChecks = 0;
+  while (settledSteps < settleSteps &&
+         (slowChecks < settleChecks || settledSteps < minSettleSteps))
+  {
+    this->StepWorld(world, 10);
+    settledSteps += 10;
+    if (maxSpeed() < settleSpeed)
+      ++slowChecks;
+    else
+      slowChecks = 0;
+  }
+  const bool settled =
+      slowChecks >= settleChecks && settledSteps >= minSettleSteps;
+  if (!settled)
+  {
+    gzwarn << "Boxes still moving after " << settleDuration
+           << " s, max speed " << maxSpeed() << std::endl;
+  }
+  this->Record("settled", settled);
+  this->Record("settleTime", settledSteps * _dt);
+  this->Record("minSettleTime", minSettleTime);
+
+  std::vector<ignition::math::Vector3d> settledPositions;
+  for (const auto &link : links)
+    settledPositions.push_back(link->WorldCoGPose().Pos());
+
+  // Timed steps of the settled boxes, with the contact count, deepest
+  // contact and fastest box of each step
+  const double simDuration = 2.0;
+  const int steps = ceil(simDuration / _dt);
+  StepTimer stepTimer;
+  ignition::math::SignalStats contactCount;
+  ignition::math::SignalStats penetration;
+  ignition::math::SignalStats jitterSpeed;
+  {
+    const std::string statNames = "maxAbs,mean";
+    EXPECT_TRUE(contactCount.InsertStatistics(statNames));
+    EXPECT_TRUE(penetration.InsertStatistics(statNames));
+    EXPECT_TRUE(jitterSpeed.InsertStatistics(statNames));
+  }
+  for (int i = 0; i < steps; ++i)
+  {
+    stepTimer.Start();
+    this->StepWorld(world, 1);
+    stepTimer.Stop();
+
+    double depth = 0.0;
+    const unsigned int count = contactManager->GetContactCount();
+    const auto &contacts = contactManager->GetContacts();
+    for (unsigned int c = 0; c < count; ++c)
+    {
+      for (int j = 0; j < contacts[c]->count; ++j)
+        depth = std::max(depth, contacts[c]->depths[j]);
+    }
+    contactCount.InsertData(count);
+    penetration.InsertData(depth);
+    jitterSpeed.InsertData(maxSpeed());
+  }
+
+  // Largest drift of a box from its settled position
+  double drift = 0.0;
+  for (size_t i = 0; i < links.size(); ++i)
+  {
+    drift = std::max(drift,
+        (links[i]->WorldCoGPose().Pos() - settledPositions[i]).Length());
+  }
+
+  this->Record("simTime", steps * _dt);
+  this->Record("stepWallTime", stepTimer.Total());
+  this->Record("stepTimeRatio", stepTimer.Total() / (steps * _dt));
+  this->Record("stepLatency_", stepTimer);
+  this->Record("bodyStepsPerSecond",
+      static_cast<double>(_modelCount) * steps / stepTimer.Total());
+  this->Record("contacts_", contactCount);
+  this->Record("contactsPerBox",
+      contactCount.Map().at("mean") / _modelCount);
+  this->Record("penetration_", penetration);
+  this->Record("jitterSpeed_", jitterSpeed);
+  this->Record("settledDrift", drift);
+}
+
+/////////////////////////////////////////////////
+void BoxesFixture::RecordBoxesParams(const std::string &_engine
+                                   , double _dt
+                                   , int _modelCount
+                                   , bool _collision)
+{
+  RecordProperty("engine", _engine);
+  if (!std::isnan(_dt))
+    this->Record("dt", _dt);
+  RecordProperty("modelCount", _modelCount);
+  RecordProperty("collision", _collision);
+}
+
+/////////////////////////////////////////////////
+void BoxesFixture::RunBoxes(const std::string &_physicsEngine
+                          , double _dt
+                          , int _modelCount
+                          , bool _collision
+                          , bool _complex
+                          , const BoxesOptions &_options)
+{
+  // sweeps and searches record dt for each case
+  const bool singleDt =
+      _options.dtSweep.empty() && !(_options.dtSearchMax > 0);
+  gzdbg << _physicsEngine;
+  if (singleDt)
+    gzdbg << ", dt: " << _dt;
+  gzdbg << ", modelCount: " << _modelCount
+        << ", collision: " << _collision
+        << ", isComplex: " << _complex;
+  if (_options.latticeSpacing > 0)
+    gzdbg << ", latticeSpacing: " << _options.latticeSpacing;
+  if (_options.islandThreads > 0 || _options.threadPositionCorrection)
+  {
+    gzdbg << ", islandThreads: " << _options.islandThreads
+          << ", threadPositionCorrection: "
+          << _options.threadPositionCorrection;
+  }
+  if (_options.linPositionTolerance > 0 || _options.angMomentumTolerance > 0)
+  {
+    gzdbg << ", linPositionTolerance: " << _options.linPositionTolerance
+          << ", angMomentumTolerance: " << _options.angMomentumTolerance;
+  }
+  if (_options.headless)
+    gzdbg << ", headless";
+  if (_options.float32State)
+    gzdbg << ", float32 state";
+  gzdbg << std::endl;
+
+  this->RecordBoxesParams(_physicsEngine
+                        , singleDt ? _dt :
+                              std::numeric_limits<double>::quiet_NaN()
+                        , _modelCount
+                        , _collision);
+  RecordProperty("isComplex", _complex);
+  this->Boxes(_physicsEngine
+            , _dt
+            , _modelCount
+            , _collision
+            , _complex
+            , _options);
+}
+
 /////////////////////////////////////////////////
 TEST_P(BoxesTest, Boxes)
 {
-  std::string physicsEngine = std::tr1::get<0>(GetParam());
+  RunBoxes(std::tr1::get<0>(GetParam())
+         , std::tr1::get<1>(GetParam())
+         , std::tr1::get<2>(GetParam())
+         , std::tr1::get<3>(GetParam())
+         , std::tr1::get<4>(GetParam()));
+}
+
+/////////////////////////////////////////////////
+TEST_P(BoxesHeadlessTest, Boxes)
+{
+  BoxesOptions options;
+  options.headless = true;
+  RunBoxes(std::tr1::get<0>(GetParam())
+         , std::tr1::get<1>(GetParam())
+         , std::tr1::get<2>(GetParam())
+         , std::tr1::get<3>(GetParam())
+         , std::tr1::get<4>(GetParam())
+         , options);
+}
+
+/////////////////////////////////////////////////
+TEST_P(BoxesFloat32Test, Boxes)
+{
+  BoxesOptions options;
+  options.float32State = true;
+  RunBoxes(std::tr1::get<0>(GetParam())
+         , std::tr1::get<1>(GetParam())
+         , std::tr1::get<2>(GetParam())
+         , std::tr1::get<3>(GetParam())
+         , std::tr1::get<4>(GetParam())
+         , options);
+}
+
+/////////////////////////////////////////////////
+TEST_P(BoxesExternalTest, Boxes)
+{
+  std::string backend       = std::tr1::get<0>(GetParam());
   double dt                 = std::tr1::get<1>(GetParam());
   int modelCount            = std::tr1::get<2>(GetParam());
-  bool collision            = std::tr1::get<3>(GetParam());
-  bool isComplex            = std::tr1::get<4>(GetParam());
-  gzdbg << physicsEngine
+  bool isComplex            = std::tr1::get<3>(GetParam());
+  gzdbg << backend
         << ", dt: " << dt
         << ", modelCount: " << modelCount
-        << ", collision: " << collision
         << ", isComplex: " << isComplex
         << std::endl;
-  RecordProperty("engine", physicsEngine);
-  this->Record("dt", dt);
-  RecordProperty("modelCount", modelCount);
-  RecordProperty("collision", collision);
+  this->RecordBoxesParams(backend, dt, modelCount, false);
   RecordProperty("isComplex", isComplex);
-  Boxes(physicsEngine
-      , dt
-      , modelCount
-      , collision
-      , isComplex);
+  BoxesExternal(backend
+              , dt
+              , modelCount
+              , isComplex);
+}
+
+/////////////////////////////////////////////////
+TEST_P(BoxesPileTest, Boxes)
+{
+  std::string physicsEngine = std::tr1::get<0>(GetParam());
+  double dt                 = std::tr1::get<1>(GetParam());
+  int modelCount            = std::tr1::get<2>(GetParam());
+  bool stacked              = std::tr1::get<3>(GetParam());
+  gzdbg << physicsEngine
+        << ", dt: " << dt
+        << ", modelCount: " << modelCount
+        << ", stacked: " << stacked
+        << std::endl;
+  this->RecordBoxesParams(physicsEngine, dt, modelCount, true);
+  BoxesPile(physicsEngine
+          , dt
+          , modelCount
+          , stacked);
+}
+
+/////////////////////////////////////////////////
+TEST_P(BoxesLatticeTest, Boxes)
+{
+  BoxesOptions options;
+  options.latticeSpacing = std::tr1::get<4>(GetParam());
+  // Shorter trajectories, since throughput rather than long term
+  // accuracy is of interest for large model counts.
+  options.simDuration = 1.0;
+  RunBoxes(std::tr1::get<0>(GetParam())
+         , std::tr1::get<1>(GetParam())
+         , std::tr1::get<2>(GetParam())
+         , std::tr1::get<3>(GetParam())
+         , true
+         , options);
+}
+
+/////////////////////////////////////////////////
+TEST_P(BoxesThreadsTest, Boxes)
+{
+  BoxesOptions options;
+  options.islandThreads = std::tr1::get<2>(GetParam());
+  options.threadPositionCorrection = std::tr1::get<3>(GetParam());
+  options.simDuration = 1.0;
+  RunBoxes(std::tr1::get<0>(GetParam())
+         , 5.0e-4
+         , std::tr1::get<1>(GetParam())
+         , true
+         , true
+         , options);
+}
+
+/////////////////////////////////////////////////
+TEST_P(BoxesDtSweepTest, Boxes)
+{
+  // Same time step sizes as BENCHMARK_boxes_dt
+  BoxesOptions options;
+  for (int i = 1; i <= 10; ++i)
+    options.dtSweep.push_back(i * 1.0e-4);
+  options.divergenceThreshold = 1.0;
+  RunBoxes(std::tr1::get<0>(GetParam())
+         , options.dtSweep.front()
+         , std::tr1::get<1>(GetParam())
+         , std::tr1::get<2>(GetParam())
+         , std::tr1::get<3>(GetParam())
+         , options);
+}
+
+/////////////////////////////////////////////////
+TEST_P(BoxesSolverTest, Boxes)
+{
+  BoxesOptions options;
+  options.latticeSpacing = std::tr1::get<2>(GetParam());
+  options.simDuration = 1.0;
+  // Reference case with a small time step and many iterations,
+  // followed by every combination of the swept settings
+  options.dtSweep.push_back(1.0e-4);
+  SolverSettings reference;
+  reference.iterations = 200;
+  reference.sor = 1.0;
+  options.solverSweep.push_back(reference);
+  for (const double dt : {2.5e-4, 5.0e-4, 1.0e-3})
+  {
+    for (const int iterations : {10, 20, 50, 100})
+    {
+      for (const double sor : {1.0, 1.3})
+      {
+        SolverSettings solver;
+        solver.iterations = iterations;
+        solver.sor = sor;
+        options.dtSweep.push_back(dt);
+        options.solverSweep.push_back(solver);
+      }
+    }
+  }
+  RunBoxes(std::tr1::get<0>(GetParam())
+         , options.dtSweep.front()
+         , std::tr1::get<1>(GetParam())
+         , true
+         , true
+         , options);
+}
+
+/////////////////////////////////////////////////
+TEST_P(BoxesDtSearchTest, Boxes)
+{
+  // Same range of time step sizes as BENCHMARK_boxes_dt
+  BoxesOptions options;
+  options.linPositionTolerance = std::tr1::get<2>(GetParam());
+  options.angMomentumTolerance = std::tr1::get<3>(GetParam());
+  options.dtSearchMin = 1.0e-4;
+  options.dtSearchMax = 1.0e-3;
+  options.dtSearchIterations =
+      OptionInt("BENCHMARK_DT_SEARCH_ITERATIONS", options.dtSearchIterations);
+  options.divergenceThreshold = 1.0;
+  RunBoxes(std::tr1::get<0>(GetParam())
+         , options.dtSearchMax
+         , 1
+         , true
+         , std::tr1::get<1>(GetParam())
+         , options);
 }
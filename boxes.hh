@@ -18,13 +18,339 @@
 #ifndef BENCHMARK_GAZEBO_BOXES_HH_
 #define BENCHMARK_GAZEBO_BOXES_HH_
 
+#include <map>
 #include <string>
-#include "gazebo/test/ServerFixture.hh"
+#include <vector>
+#include <ignition/math/Vector3.hh>
+#include "benchmark_fixture.hh"
 
 namespace gazebo
 {
   namespace benchmark
   {
+    /// \brief Iterative solver settings of a time step size case,
+    /// used by the ODE and Bullet engines.
+    struct SolverSettings
+    {
+      /// \brief Number of solver iterations (iters), 0 for the default.
+      int iterations = 0;
+
+      /// \brief Successive over-relaxation parameter (sor),
+      /// 0 for the default.
+      double sor = 0.0;
+    };
+
+    /// \brief Settings for BoxesFixture::Boxes that are not part of
+    /// the BoxesTest parameter tuple.
+    struct BoxesOptions
+    {
+      /// \brief Spacing between neighboring boxes on a 3D lattice, as a
+      /// multiple of the largest box extent, so that boxes start apart
+      /// for values above 1.0. Neighbors can touch while tumbling below
+      /// the ratio of the box diagonal to its largest extent, about 1.1.
+      /// When 0, boxes are spawned along a line with wide gaps between
+      /// them.
+      double latticeSpacing = 0.0;
+
+      /// \brief Duration of each timed trial in simulated seconds.
+      double simDuration = 10.0;
+
+      /// \brief Load all boxes with the world from one generated sdf file
+      /// instead of spawning them one at a time. Can be overridden with
+      /// the BENCHMARK_BATCH_SPAWN environment variable.
+      bool batchSpawn = true;
+
+      /// \brief Number of threads used to step independent islands in
+      /// parallel (ODE island_threads), 0 for the engine default.
+      /// When this or threadPositionCorrection is set, a baseline run
+      /// with the engine defaults is timed first and the speedup and
+      /// parallel efficiency (speedup / islandThreads) are recorded.
+      int islandThreads = 0;
+
+      /// \brief Solve position correction in a separate thread
+      /// (ODE thread_position_correction).
+      bool threadPositionCorrection = false;
+
+      /// \brief Track position, velocity and angular momentum errors of
+      /// every box instead of only the last one. The extra time is
+      /// recorded as allBodyWallTime but is included in wallTime and
+      /// timeRatio, so it is off by default. Can be overridden with the
+      /// BENCHMARK_ALL_BODY_ERRORS environment variable.
+      bool allBodyErrors = false;
+
+      /// \brief Time step sizes to run one after another in the same
+      /// world, restored from a snapshot of the initial state instead of
+      /// reloading it for each value. Each value is recorded as a separate
+      /// case. When empty, only the _dt argument of Boxes is run.
+      std::vector<double> dtSweep;
+
+      /// \brief Solver settings of each case of dtSweep, empty to keep the
+      /// engine defaults, or the same size as dtSweep. The first case is
+      /// a reference for the final positions of all boxes, recorded in
+      /// the refPositionErr columns of later cases; when boxes collide
+      /// their trajectories have no analytic solution.
+      std::vector<SolverSettings> solverSweep;
+
+      /// \brief Load the world in the test process with LoadHeadless
+      /// instead of starting gzserver, and step it on the test thread.
+      /// Boxes are always loaded with the world.
+      bool headless = false;
+
+      /// \brief Round the pose and velocities of every box to single
+      /// precision after each step, as if the engine stored its state in
+      /// float32, to measure the accuracy lost with a float32 state.
+      /// The rounding adds work to a double precision engine, so only
+      /// the accuracy columns are recorded, not the step times.
+      /// Can be overridden with BENCHMARK_FLOAT32_STATE.
+      bool float32State = false;
+
+      /// \brief Abort a trial once the linear position error of the
+      /// tracked box exceeds this value, 0 to disable.
+      double linPositionTolerance = 0.0;
+
+      /// \brief Abort a trial once the relative angular momentum error of
+      /// the tracked box exceeds this value, 0 to disable.
+      double angMomentumTolerance = 0.0;
+
+      /// \brief Stop a trial once the relative energy or angular momentum
+      /// error of the tracked box exceeds this value, since the remaining
+      /// steps would only measure a diverged solution. wallTime,
+      /// timeRatio, stepWallTime and stepTimeRatio are NaN for a case that
+      /// stopped early. 0 to disable, the default except for the dt sweep
+      /// and search tests.
+      /// Can be overridden with BENCHMARK_DIVERGENCE_THRESHOLD.
+      double divergenceThreshold = 0.0;
+
+      /// \brief Number of steps between divergence checks.
+      /// Can be overridden with BENCHMARK_DIVERGENCE_INTERVAL.
+      int divergenceInterval = 100;
+
+      /// \brief When greater than 0, search for the largest time step size
+      /// between dtSearchMin and dtSearchMax whose errors are within the
+      /// tolerances instead of running dtSweep. Each time step size tried
+      /// is recorded as a separate case.
+      double dtSearchMax = 0.0;
+
+      /// \brief Smallest time step size of the search.
+      double dtSearchMin = 0.0;
+
+      /// \brief Number of bisection steps of the search.
+      int dtSearchIterations = 5;
+    };
+
+    /// \brief Loaded boxes and initial state, defined in boxes.cc.
+    struct BoxesWorld;
+
+    /// \brief Trial settings of Boxes, defined in boxes.cc.
+    struct BoxesTrialSettings;
+
+    /// \brief Measurements of one time step size case, defined in
+    /// boxes.cc.
+    struct BoxesCase;
+
+    /// \brief Fixture that spawns free-floating boxes and measures
+    /// accuracy and computational cost.
+    class BoxesFixture : public BenchmarkFixture
+    {
+      /// \brief Test accuracy of unconstrained rigid body motion.
+      /// \param[in] _physicsEngine Physics engine to use.
+      /// \param[in] _dt Max time step size.
+      /// \param[in] _modelCount Number of boxes to spawn.
+      /// \param[in] _collision Flag for collision shape on / off.
+      /// \param[in] _complex Flag for complex trajectory on / off.
+      /// \param[in] _options Additional settings.
+      public: void Boxes(const std::string &_physicsEngine
+                       , double _dt
+                       , int _modelCount
+                       , bool _collision
+                       , bool _complex
+                       , const BoxesOptions &_options = BoxesOptions());
+
+      /// \brief Record the test parameters shared by every boxes test.
+      /// \param[in] _engine Physics engine or external backend.
+      /// \param[in] _dt Max time step size, or NaN when a sweep or search
+      /// records dt for each case instead.
+      /// \param[in] _modelCount Number of boxes.
+      /// \param[in] _collision Flag for collision shape on / off.
+      public: void RecordBoxesParams(const std::string &_engine
+                                   , double _dt
+                                   , int _modelCount
+                                   , bool _collision);
+
+      /// \brief Log and record the test parameters shared by the Boxes
+      /// tests (engine, dt without a sweep or search, modelCount,
+      /// collision and isComplex) and run Boxes, so that each TEST_P only
+      /// sets its options.
+      /// \param[in] _physicsEngine Physics engine to use.
+      /// \param[in] _dt Max time step size.
+      /// \param[in] _modelCount Number of boxes to spawn.
+      /// \param[in] _collision Flag for collision shape on / off.
+      /// \param[in] _complex Flag for complex trajectory on / off.
+      /// \param[in] _options Additional settings.
+      public: void RunBoxes(const std::string &_physicsEngine
+                          , double _dt
+                          , int _modelCount
+                          , bool _collision
+                          , bool _complex
+                          , const BoxesOptions &_options = BoxesOptions());
+
+      /// \brief Run the boxes problem of Boxes, without collision shapes,
+      /// on an external simulator loaded with LoadBoxesBackend, and record
+      /// the same timing and error statistics as Boxes. The time of all
+      /// steps in a single BoxesBackend::Step call is recorded as
+      /// batchWallTime and batchBodyStepsPerSecond.
+      /// \param[in] _backend Backend name or library path.
+      /// \param[in] _dt Time step size.
+      /// \param[in] _modelCount Number of boxes.
+      /// \param[in] _complex Flag for complex trajectory on / off.
+      public: void BoxesExternal(const std::string &_backend
+                               , double _dt
+                               , int _modelCount
+                               , bool _complex);
+
+      /// \brief Rest boxes on a ground plane in stacks or drop them into
+      /// piles, let them settle, and time steps where every box is in
+      /// contact. Records the step time, contacts per step, the deepest
+      /// contact penetration of each step (penetration_), the speed of the
+      /// fastest box of each step (jitterSpeed_) and the largest drift from
+      /// the settled positions (settledDrift).
+      /// \param[in] _physicsEngine Physics engine to use.
+      /// \param[in] _dt Max time step size.
+      /// \param[in] _modelCount Number of boxes.
+      /// \param[in] _stacked True for columns of boxes lying on their
+      /// largest face, false for tilted boxes dropped on each other.
+      public: void BoxesPile(const std::string &_physicsEngine
+                           , double _dt
+                           , int _modelCount
+                           , bool _stacked);
+
+      /// \brief Load the world and boxes of Boxes, set their initial
+      /// velocities and capture a snapshot of the initial state.
+      /// \param[in] _physicsEngine Physics engine to use.
+      /// \param[in] _modelCount Number of boxes to spawn.
+      /// \param[in] _collision Flag for collision shape on / off.
+      /// \param[in] _complex Flag for complex trajectory on / off.
+      /// \param[in] _options Additional settings.
+      /// \param[out] _boxes Loaded world and initial state.
+      protected: void LoadBoxes(const std::string &_physicsEngine
+                              , int _modelCount
+                              , bool _collision
+                              , bool _complex
+                              , const BoxesOptions &_options
+                              , BoxesWorld &_boxes);
+
+      /// \brief Read and record the trial settings of Boxes from the
+      /// options and their environment variable overrides.
+      /// \param[in] _options Additional settings of Boxes.
+      /// \param[out] _settings Trial settings.
+      protected: void ReadTrialSettings(const BoxesOptions &_options
+                                      , BoxesTrialSettings &_settings);
+
+      /// \brief Open the performance counters of the world update thread
+      /// if BENCHMARK_PERF_COUNTERS is set, stepping the world once if its
+      /// thread id is not known yet.
+      /// \param[in] _boxes Loaded world, restored after a step.
+      /// \param[out] _counters Performance counters.
+      /// \return True if the counters are open.
+      protected: bool OpenPerfCounters(BoxesWorld &_boxes
+                                     , PerfCounters &_counters);
+
+      /// \brief Set and record the iterative solver settings of a case.
+      /// \param[in] _physicsEngine Physics engine name, for warnings.
+      /// \param[in] _solver Solver settings.
+      /// \param[in] _boxes Loaded world.
+      protected: void SetSolverSettings(const std::string &_physicsEngine
+                                      , const SolverSettings &_solver
+                                      , BoxesWorld &_boxes);
+
+      /// \brief Time the steps of a case with the engine default parallel
+      /// settings, then set the parallel settings of the options.
+      /// \param[in] _physicsEngine Physics engine name, for warnings.
+      /// \param[in] _options Parallel settings.
+      /// \param[in] _steps Number of steps.
+      /// \param[in] _restore Restore the initial state first.
+      /// \param[in] _resetParams Reset the parallel settings of a previous
+      /// case to the engine defaults first.
+      /// \param[in] _boxes Loaded world.
+      /// \return Total step time of the baseline.
+      protected: double ParallelBaseline(const std::string &_physicsEngine
+                                       , const BoxesOptions &_options
+                                       , int _steps
+                                       , bool _restore
+                                       , bool _resetParams
+                                       , BoxesWorld &_boxes);
+
+      /// \brief Open the trajectory file of a case in
+      /// BENCHMARK_TRAJECTORY_DIR, if set.
+      /// \param[in] _params Test parameters in the file header.
+      /// \param[in] _suffix Suffix of the file name for sweep cases.
+      /// \param[in] _steps Number of steps of a trial.
+      /// \param[in,out] _case Case whose trajectory is opened.
+      protected: void OpenTrajectory(
+                     const std::map<std::string, std::string> &_params
+                   , const std::string &_suffix
+                   , int _steps
+                   , BoxesCase &_case);
+
+      /// \brief Run the timed trials of a case, each from the initial
+      /// state, and gather the errors of the tracked box and optionally
+      /// every box. Trials stop early above the error limits.
+      /// \param[in] _settings Trial settings.
+      /// \param[in] _complex Flag for complex trajectory on / off.
+      /// \param[in] _steps Number of steps of a trial.
+      /// \param[in] _simDuration Expected sim time of a trial.
+      /// \param[in] _restore Restore the initial state before the first
+      /// trial.
+      /// \param[in] _boxes Loaded world.
+      /// \param[in] _counters Performance counters, started and stopped
+      /// around the trials.
+      /// \param[in,out] _case Measurements of the case.
+      protected: void RunTrials(const BoxesTrialSettings &_settings
+                              , bool _complex
+                              , int _steps
+                              , double _simDuration
+                              , bool _restore
+                              , BoxesWorld &_boxes
+                              , PerfCounters &_counters
+                              , BoxesCase &_case);
+
+      /// \brief Record the wall time, step time and memory of a case.
+      /// \param[in] _settings Trial settings.
+      /// \param[in] _modelCount Number of boxes.
+      /// \param[in] _case Measurements of the case.
+      /// \param[in] _counters Stopped performance counters.
+      /// \return Body steps per second of the case, or NaN with a float32
+      /// state, whose step times are not recorded.
+      protected: double RecordCaseTimes(const BoxesTrialSettings &_settings
+                                      , int _modelCount
+                                      , const BoxesCase &_case
+                                      , const PerfCounters &_counters);
+
+      /// \brief Record the final position errors of every box relative to
+      /// the first case of a solver sweep, or NaN when this case or the
+      /// reference stopped early.
+      /// \param[in] _dtCase Index of the case, 0 for the reference.
+      /// \param[in] _completed True if the case was not stopped early.
+      /// \param[in] _boxes Loaded world.
+      /// \param[in,out] _referencePositions Final positions of the
+      /// reference case, set by the first case.
+      protected: void RecordReferenceError(
+                     size_t _dtCase
+                   , bool _completed
+                   , const BoxesWorld &_boxes
+                   , std::vector<ignition::math::Vector3d>
+                     &_referencePositions);
+
+      /// \brief Record the error statistics of the tracked box and, with
+      /// allBodyErrors, of every box.
+      /// \param[in] _settings Trial settings.
+      /// \param[in] _boxes Loaded world and initial state.
+      /// \param[in] _case Measurements of the case.
+      protected: void RecordCaseErrors(const BoxesTrialSettings &_settings
+                                     , const BoxesWorld &_boxes
+                                     , BoxesCase &_case);
+    };
+
     // physics engine
     // dt
     // number of boxes to spawn
@@ -36,20 +362,134 @@ namespace gazebo
                             , bool
                             , bool
                             > char1double1int1bool2;
-    class BoxesTest : public ServerFixture,
+    class BoxesTest : public BoxesFixture,
                       public testing::WithParamInterface<char1double1int1bool2>
     {
-      /// \brief Test accuracy of unconstrained rigid body motion.
-      /// \param[in] _physicsEngine Physics engine to use.
-      /// \param[in] _dt Max time step size.
-      /// \param[in] _modelCount Number of boxes to spawn.
-      /// \param[in] _collision Flag for collision shape on / off.
-      /// \param[in] _complex Flag for complex trajectory on / off.
-      public: void Boxes(const std::string &_physicsEngine
-                       , double _dt
-                       , int _modelCount
-                       , bool _collision
-                       , bool _complex);
+    };
+
+    /// \brief Same parameters as BoxesTest, with the world loaded
+    /// in the test process instead of gzserver.
+    class BoxesHeadlessTest : public BoxesFixture,
+        public testing::WithParamInterface<char1double1int1bool2>
+    {
+    };
+
+    // physics engine
+    // dt
+    // number of boxes
+    // stacked / dropped
+    typedef std::tr1::tuple < const char *
+                            , double
+                            , int
+                            , bool
+                            > char1double1int1bool1;
+    /// \brief Boxes resting in stacks and piles on a ground plane.
+    class BoxesPileTest : public BoxesFixture,
+        public testing::WithParamInterface<char1double1int1bool1>
+    {
+    };
+
+    // physics engine
+    // dt
+    // number of boxes to spawn
+    // collision shape on / off
+    // lattice spacing relative to the largest box extent
+    typedef std::tr1::tuple < const char *
+                            , double
+                            , int
+                            , bool
+                            , double
+                            > char1double1int1bool1double1;
+    /// \brief Same parameters as BoxesTest, with the state of every box
+    /// rounded to single precision after each step.
+    class BoxesFloat32Test : public BoxesFixture,
+        public testing::WithParamInterface<char1double1int1bool2>
+    {
+    };
+
+    // backend name or library path
+    // dt
+    // number of boxes
+    // complex trajectory on / off
+    typedef std::tr1::tuple < std::string
+                            , double
+                            , int
+                            , bool
+                            > string1double1int1bool1;
+    /// \brief Boxes on an external simulator backend.
+    class BoxesExternalTest : public BoxesFixture,
+        public testing::WithParamInterface<string1double1int1bool1>
+    {
+    };
+
+    /// \brief Boxes with complex trajectories on a 3D lattice,
+    /// used for large model count scaling.
+    class BoxesLatticeTest : public BoxesFixture,
+        public testing::WithParamInterface<char1double1int1bool1double1>
+    {
+    };
+
+    // physics engine
+    // number of boxes to spawn
+    // number of island threads
+    // threaded position correction on / off
+    typedef std::tr1::tuple < const char *
+                            , int
+                            , int
+                            , bool
+                            > char1int2bool1;
+    /// \brief Boxes with collisions in separate islands, stepped with
+    /// the parallel solver settings of the physics engine.
+    class BoxesThreadsTest : public BoxesFixture,
+        public testing::WithParamInterface<char1int2bool1>
+    {
+    };
+
+    // physics engine
+    // number of boxes to spawn
+    // collision shape on / off
+    // complex trajectory on / off
+    typedef std::tr1::tuple < const char *
+                            , int
+                            , bool
+                            , bool
+                            > char1int1bool2;
+    /// \brief Boxes loaded once per parameter set and run with a sweep of
+    /// time step sizes.
+    class BoxesDtSweepTest : public BoxesFixture,
+        public testing::WithParamInterface<char1int1bool2>
+    {
+    };
+
+    // physics engine
+    // number of boxes to spawn
+    // lattice spacing relative to the largest box extent
+    typedef std::tr1::tuple < const char *
+                            , int
+                            , double
+                            > char1int1double1;
+    /// \brief Colliding boxes on a lattice run with a sweep of time step
+    /// sizes and iterative solver settings, for the accuracy and cost
+    /// trade-off of each setting.
+    class BoxesSolverTest : public BoxesFixture,
+        public testing::WithParamInterface<char1int1double1>
+    {
+    };
+
+    // physics engine
+    // complex trajectory on / off
+    // linear position error tolerance
+    // angular momentum error tolerance
+    typedef std::tr1::tuple < const char *
+                            , bool
+                            , double
+                            , double
+                            > char1bool1double2;
+    /// \brief Search for the largest time step size with errors
+    /// within the given tolerances.
+    class BoxesDtSearchTest : public BoxesFixture,
+        public testing::WithParamInterface<char1bool1double2>
+    {
     };
   }
 }
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <dlfcn.h>
+#include <unistd.h>
+
+#include <sstream>
+
+#include "benchmark_options.hh"
+#include "boxes_backend.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+// Split a string at a separator, skipping empty parts.
+static std::vector<std::string> Split(const std::string &_text, char _sep)
+{
+  std::vector<std::string> parts;
+  std::istringstream stream(_text);
+  std::string part;
+  while (std::getline(stream, part, _sep))
+  {
+    if (!part.empty())
+      parts.push_back(part);
+  }
+  return parts;
+}
+
+/////////////////////////////////////////////////
+BoxesBackendPtr gazebo::benchmark::LoadBoxesBackend(const std::string &_name,
+    std::string &_error)
+{
+  std::string path = _name;
+  if (_name.find('/') == std::string::npos)
+  {
+    const std::string library = "libboxes_backend_" + _name + ".so";
+    path = library;
+    for (const auto &dir : Split(OptionString("BENCHMARK_BACKEND_PATH"), ':'))
+    {
+      const std::string candidate = dir + "/" + library;
+      if (access(candidate.c_str(), R_OK) == 0)
+      {
+        path = candidate;
+        break;
+      }
+    }
+  }
+
+  void *handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (!handle)
+  {
+    _error = dlerror();
+    return BoxesBackendPtr();
+  }
+  typedef BoxesBackend *(*CreateFunction)();
+  const auto create =
+      reinterpret_cast<CreateFunction>(dlsym(handle, "CreateBoxesBackend"));
+  BoxesBackend *backend = create ? create() : nullptr;
+  if (!backend)
+  {
+    _error = path + " does not define a backend with BENCHMARK_BOXES_BACKEND";
+    dlclose(handle);
+    return BoxesBackendPtr();
+  }
+
+  // The code of the backend lives in the library, so it is unloaded
+  // after the backend is destroyed
+  return BoxesBackendPtr(backend, [handle](BoxesBackend *_backend)
+      {
+        delete _backend;
+        dlclose(handle);
+      });
+}
+
+/////////////////////////////////////////////////
+std::vector<std::string> gazebo::benchmark::BoxesBackendNames()
+{
+  return Split(OptionString("BENCHMARK_BOXES_BACKENDS", "reference"), ',');
+}
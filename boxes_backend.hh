@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_BOXES_BACKEND_HH_
+#define BENCHMARK_GAZEBO_BOXES_BACKEND_HH_
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Vector in the world frame.
+    typedef std::array<double, 3> BackendVector;
+
+    /// \brief Free-floating boxes problem of BoxesFixture::Boxes, for a
+    /// simulator outside of gazebo. All boxes have the same size, mass
+    /// and initial velocities, and no collision shapes.
+    struct BoxesProblem
+    {
+      /// \brief Number of boxes.
+      int modelCount = 0;
+
+      /// \brief Time step size.
+      double dt = 0.0;
+
+      /// \brief Box size along each axis of the box frame.
+      BackendVector size = {{0, 0, 0}};
+
+      /// \brief Mass of each box.
+      double mass = 0.0;
+
+      /// \brief Principal moments of inertia about the box axes.
+      BackendVector inertia = {{0, 0, 0}};
+
+      /// \brief Gravity.
+      BackendVector gravity = {{0, 0, 0}};
+
+      /// \brief Initial linear velocity of every box.
+      BackendVector linearVel = {{0, 0, 0}};
+
+      /// \brief Initial angular velocity of every box.
+      BackendVector angularVel = {{0, 0, 0}};
+
+      /// \brief Initial position of each box, with the box axes aligned
+      /// with the world axes.
+      std::vector<BackendVector> positions;
+    };
+
+    /// \brief State of one box in the world frame.
+    struct BoxesBodyState
+    {
+      /// \brief Position of the center of mass.
+      BackendVector position = {{0, 0, 0}};
+
+      /// \brief Orientation as a unit quaternion (w, x, y, z).
+      std::array<double, 4> orientation = {{1, 0, 0, 0}};
+
+      /// \brief Linear velocity of the center of mass.
+      BackendVector linearVel = {{0, 0, 0}};
+
+      /// \brief Angular velocity.
+      BackendVector angularVel = {{0, 0, 0}};
+    };
+
+    /// \brief Interface of an external simulator used by
+    /// BoxesFixture::BoxesExternal, so that the boxes problem, its analytic
+    /// solution and error metrics can be compared with the gazebo engines.
+    ///
+    /// Backends are shared libraries built with the same compiler, named
+    /// libboxes_backend_<name>.so, that define their class with
+    /// BENCHMARK_BOXES_BACKEND. The header has no gazebo dependencies.
+    class BoxesBackend
+    {
+      /// \brief Destructor.
+      public: virtual ~BoxesBackend() = default;
+
+      /// \brief Backend name recorded in the engine column.
+      public: virtual std::string Name() const = 0;
+
+      /// \brief Create the boxes, replacing any previous problem.
+      /// \param[in] _problem Problem to simulate.
+      /// \return False if the problem is not supported.
+      public: virtual bool Load(const BoxesProblem &_problem) = 0;
+
+      /// \brief Advance every box, and return once the state is available.
+      /// \param[in] _steps Number of time steps.
+      /// \return False on failure.
+      public: virtual bool Step(int _steps) = 0;
+
+      /// \brief State of a box after the last Step.
+      /// \param[in] _index Box index, in the order of the positions.
+      /// \param[out] _state Box state.
+      public: virtual void State(int _index, BoxesBodyState &_state) = 0;
+    };
+
+    /// \brief Shared pointer to a backend, which unloads its library.
+    typedef std::shared_ptr<BoxesBackend> BoxesBackendPtr;
+
+    /// \brief Load a backend library.
+    /// \param[in] _name Library path, or backend name searched as
+    /// libboxes_backend_<name>.so in the folders of BENCHMARK_BACKEND_PATH
+    /// (separated by colons) and then the library search path.
+    /// \param[out] _error Reason for a failure.
+    /// \return Backend, or nullptr.
+    BoxesBackendPtr LoadBoxesBackend(const std::string &_name,
+                                     std::string &_error);
+
+    /// \brief Names of the backends of the BENCHMARK_BOXES_BACKENDS
+    /// environment variable, separated by commas (default "reference").
+    std::vector<std::string> BoxesBackendNames();
+  }
+}
+
+/// \brief Define the factory function of a backend library.
+/// \param[in] ClassName Class derived from BoxesBackend.
+#define BENCHMARK_BOXES_BACKEND(ClassName) \
+  extern "C" gazebo::benchmark::BoxesBackend *CreateBoxesBackend() \
+  { \
+    return new ClassName(); \
+  }
+
+#endif
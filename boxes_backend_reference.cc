@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "boxes_backend.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+namespace
+{
+  /// \brief Reference backend that integrates every box with
+  /// semi-implicit Euler steps, stored as one array per state variable
+  /// as a data-parallel simulator would. Angular momentum in the world
+  /// frame is constant without torques, so the angular velocity is
+  /// computed from it and the current orientation at each step.
+  /// Also a template for new backends.
+  class ReferenceBoxesBackend : public BoxesBackend
+  {
+    // Documentation inherited
+    public: std::string Name() const override
+    {
+      return "reference";
+    }
+
+    // Documentation inherited
+    public: bool Load(const BoxesProblem &_problem) override
+    {
+      this->problem = _problem;
+      const size_t n = _problem.positions.size();
+      this->positions = _problem.positions;
+      this->velocities.assign(n, _problem.linearVel);
+      this->orientations.assign(n, {{1, 0, 0, 0}});
+      this->angularVels.assign(n, _problem.angularVel);
+
+      // Box axes are aligned with the world axes initially
+      BackendVector momentum;
+      for (int i = 0; i < 3; ++i)
+        momentum[i] = _problem.inertia[i] * _problem.angularVel[i];
+      this->momenta.assign(n, momentum);
+      return _problem.dt > 0 && _problem.mass > 0;
+    }
+
+    // Documentation inherited
+    public: bool Step(int _steps) override
+    {
+      const double dt = this->problem.dt;
+      const BackendVector &g = this->problem.gravity;
+      const BackendVector &I = this->problem.inertia;
+      for (int step = 0; step < _steps; ++step)
+      {
+        for (size_t b = 0; b < this->positions.size(); ++b)
+        {
+          BackendVector &p = this->positions[b];
+          BackendVector &v = this->velocities[b];
+          for (int i = 0; i < 3; ++i)
+          {
+            v[i] += g[i] * dt;
+            p[i] += v[i] * dt;
+          }
+
+          // w = R I^-1 R^T L
+          std::array<double, 4> &q = this->orientations[b];
+          const BackendVector local = Rotate(q, this->momenta[b], true);
+          BackendVector w = Rotate(q,
+              {{local[0] / I[0], local[1] / I[1], local[2] / I[2]}}, false);
+          this->angularVels[b] = w;
+
+          // q += 0.5 dt (0, w) q
+          const std::array<double, 4> dq = {{
+              -w[0] * q[1] - w[1] * q[2] - w[2] * q[3],
+               w[0] * q[0] + w[1] * q[3] - w[2] * q[2],
+              -w[0] * q[3] + w[1] * q[0] + w[2] * q[1],
+               w[0] * q[2] - w[1] * q[1] + w[2] * q[0]}};
+          double norm = 0;
+          for (int i = 0; i < 4; ++i)
+          {
+            q[i] += 0.5 * dt * dq[i];
+            norm += q[i] * q[i];
+          }
+          norm = std::sqrt(norm);
+          for (int i = 0; i < 4; ++i)
+            q[i] /= norm;
+        }
+      }
+      return true;
+    }
+
+    // Documentation inherited
+    public: void State(int _index, BoxesBodyState &_state) override
+    {
+      _state.position = this->positions[_index];
+      _state.orientation = this->orientations[_index];
+      _state.linearVel = this->velocities[_index];
+      _state.angularVel = this->angularVels[_index];
+    }
+
+    /// \brief Rotate a vector by a unit quaternion or its inverse.
+    /// \param[in] _q Quaternion (w, x, y, z).
+    /// \param[in] _v Vector.
+    /// \param[in] _inverse True to rotate by the inverse.
+    /// \return Rotated vector.
+    private: static BackendVector Rotate(const std::array<double, 4> &_q,
+                                         const BackendVector &_v,
+                                         bool _inverse)
+    {
+      const double s = _inverse ? -1 : 1;
+      const BackendVector u = {{s * _q[1], s * _q[2], s * _q[3]}};
+      const double w = _q[0];
+      // v + 2 u x (u x v + w v)
+      const BackendVector t = {{
+          u[1] * _v[2] - u[2] * _v[1] + w * _v[0],
+          u[2] * _v[0] - u[0] * _v[2] + w * _v[1],
+          u[0] * _v[1] - u[1] * _v[0] + w * _v[2]}};
+      return {{
+          _v[0] + 2 * (u[1] * t[2] - u[2] * t[1]),
+          _v[1] + 2 * (u[2] * t[0] - u[0] * t[2]),
+          _v[2] + 2 * (u[0] * t[1] - u[1] * t[0])}};
+    }
+
+    /// \brief Problem being simulated.
+    private: BoxesProblem problem;
+
+    /// \brief Positions of the boxes.
+    private: std::vector<BackendVector> positions;
+
+    /// \brief Linear velocities of the boxes.
+    private: std::vector<BackendVector> velocities;
+
+    /// \brief Orientations of the boxes.
+    private: std::vector<std::array<double, 4>> orientations;
+
+    /// \brief Angular velocities of the boxes after the last step.
+    private: std::vector<BackendVector> angularVels;
+
+    /// \brief Angular momenta of the boxes in the world frame.
+    private: std::vector<BackendVector> momenta;
+  };
+}
+
+BENCHMARK_BOXES_BACKEND(ReferenceBoxesBackend)
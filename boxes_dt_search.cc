@@ -0,0 +1,38 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <string.h>
+
+#include "boxes.hh"
+#include "gazebo/test/helper_physics_generator.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+// Largest dt between 1e-4 and 1e-3 within each pair of tolerances on
+// the linear position and relative angular momentum errors
+INSTANTIATE_TEST_CASE_P(EnginesDtSearch, BoxesDtSearchTest,
+  ::testing::Combine(PHYSICS_ENGINE_VALUES
+  , ::testing::Bool()
+  , ::testing::Values(1e-5, 1e-3)
+  , ::testing::Values(1e-3)));
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
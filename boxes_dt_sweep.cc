@@ -0,0 +1,37 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <string.h>
+
+#include "boxes.hh"
+#include "gazebo/test/helper_physics_generator.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+// Each test case sweeps dt from 1e-4 to 1e-3 in one loaded world
+INSTANTIATE_TEST_CASE_P(EnginesDtSweep, BoxesDtSweepTest,
+  ::testing::Combine(PHYSICS_ENGINE_VALUES
+  , ::testing::Values(1)
+  , ::testing::Values(true)
+  , ::testing::Bool()));
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
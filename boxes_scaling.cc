@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <string.h>
+
+#include "boxes.hh"
+#include "gazebo/test/helper_physics_generator.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+// Model counts swept geometrically to expose superlinear scaling
+// of broadphase collision and island solvers.
+#define MODEL_COUNT_VALUES ::testing::Values(1, 10, 100, 1000, 10000)
+
+// Lattice spacing as a multiple of the largest box extent:
+// 1.05: neighboring boxes start apart and collide while tumbling
+// 1.2: neighbors are just farther apart than the box diagonal
+// 2.0: sparse lattice
+#define LATTICE_SPACING_VALUES ::testing::Values(1.05, 1.2, 2.0)
+
+INSTANTIATE_TEST_CASE_P(OdeLattice, BoxesLatticeTest,
+  ::testing::Combine(::testing::Values("ode")
+  , ::testing::Values(5.0e-4)
+  , MODEL_COUNT_VALUES
+  , ::testing::Bool()
+  , LATTICE_SPACING_VALUES));
+
+#ifdef HAVE_BULLET
+INSTANTIATE_TEST_CASE_P(BulletLattice, BoxesLatticeTest,
+  ::testing::Combine(::testing::Values("bullet")
+  , ::testing::Values(5.0e-4)
+  , MODEL_COUNT_VALUES
+  , ::testing::Bool()
+  , LATTICE_SPACING_VALUES));
+#endif
+
+#ifdef HAVE_SIMBODY
+INSTANTIATE_TEST_CASE_P(SimbodyLattice, BoxesLatticeTest,
+  ::testing::Combine(::testing::Values("simbody")
+  , ::testing::Values(1.0e-3)
+  , MODEL_COUNT_VALUES
+  , ::testing::Bool()
+  , LATTICE_SPACING_VALUES));
+#endif
+
+#ifdef HAVE_DART
+INSTANTIATE_TEST_CASE_P(DartLattice, BoxesLatticeTest,
+  ::testing::Combine(::testing::Values("dart")
+  , ::testing::Values(5.0e-4)
+  , MODEL_COUNT_VALUES
+  , ::testing::Bool()
+  , LATTICE_SPACING_VALUES));
+#endif
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <string.h>
+
+#include "boxes.hh"
+#include "gazebo/test/helper_physics_generator.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+// Of the engines built into gazebo, only ODE can step islands
+// in parallel, so it is the only engine instantiated here.
+// Each box is spawned far from the others, forming its own island.
+INSTANTIATE_TEST_CASE_P(OdeThreads, BoxesThreadsTest,
+  ::testing::Combine(::testing::Values("ode")
+  , ::testing::Values(100, 1000)
+  , ::testing::Values(1, 2, 4, 8, 16)
+  , ::testing::Bool()));
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -14,13 +14,29 @@
  * limitations under the License.
  *
 */
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <map>
+#include <random>
 #include <string>
-#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+#include <ignition/math/SignalStats.hh>
 
 #include "gazebo/msgs/msgs.hh"
 #include "gazebo/physics/physics.hh"
+#include "gazebo/transport/transport.hh"
+#include "benchmark_options.hh"
 #include "collide_spheres.hh"
+#include "memory_stats.hh"
+#include "perf_counters.hh"
+#include "replay_log.hh"
+#include "step_timer.hh"
+#include "world_builder.hh"
+#include "world_snapshot.hh"
 
 using namespace gazebo;
 using namespace benchmark;
@@ -29,14 +45,174 @@ void OnContacts(ConstContactsPtr &/*_msg*/)
 {
 }
 
-typedef std::map<double, std::pair<physics::ModelPtr, physics::ModelPtr>>
-        mapSeparatedModels;
+/////////////////////////////////////////////////
+// Group the models of a world into sphere pairs by name.
+static std::vector<SpherePair> FindSpherePairs(physics::WorldPtr _world)
+{
+  std::map<std::string, SpherePair> pairs;
+  for (const auto model : _world->Models())
+  {
+    const auto name = model->GetName();
+    double radius;
+    if (name.find("mm") == 0)
+      radius = 1e-3;
+    else if (name.find("dm") == 0)
+      radius = 1e-1;
+    else
+      continue;
+    if (name.size() < 5)
+    {
+      gzerr << "Unrecognized model name: " << name << std::endl;
+      continue;
+    }
+
+    // name without the A / B suffix identifies the pair
+    SpherePair &pair = pairs[name.substr(0, 4) + name.substr(5)];
+    pair.radius = radius;
+    pair.separation = std::stod(name.substr(2, 2)) / 10 * radius;
+    if (name.at(4) == 'A')
+    {
+      pair.a = model;
+    }
+    else if (name.at(4) == 'B')
+    {
+      pair.b = model;
+    }
+    else
+    {
+      gzerr << "Unrecognized model name: " << name << std::endl;
+    }
+  }
+
+  std::vector<SpherePair> result;
+  for (const auto &pair : pairs)
+    result.push_back(pair.second);
+  return result;
+}
+
+/////////////////////////////////////////////////
+// Number of pairs that touch or overlap.
+static unsigned int ExpectedContactCount(const std::vector<SpherePair> &_pairs)
+{
+  unsigned int count = 0;
+  for (const auto &pair : _pairs)
+  {
+    if (pair.separation <= 2 * pair.radius * (1 + 1e-9))
+      ++count;
+  }
+  return count;
+}
+
+/////////////////////////////////////////////////
+void CollideFixture::RecordContactErrors(
+    physics::ContactManager *_contactManager,
+    const std::vector<SpherePair> &_pairs)
+{
+  std::map<std::string, size_t> pairIndex;
+  for (size_t i = 0; i < _pairs.size(); ++i)
+  {
+    pairIndex[_pairs[i].a->GetName()] = i;
+    pairIndex[_pairs[i].b->GetName()] = i;
+  }
+
+  ignition::math::SignalStats depthError;
+  ignition::math::SignalStats normalError;
+  depthError.InsertStatistics("maxAbs");
+  normalError.InsertStatistics("maxAbs");
+  std::vector<bool> found(_pairs.size(), false);
+  unsigned int unexpected = 0;
+
+  const unsigned int contactCount = _contactManager->GetContactCount();
+  const auto &contacts = _contactManager->GetContacts();
+  for (unsigned int i = 0; i < contactCount; ++i)
+  {
+    const auto contact = contacts[i];
+    const auto name1 = contact->collision1->GetLink()->GetModel()->GetName();
+    const auto name2 = contact->collision2->GetLink()->GetModel()->GetName();
+    const auto iter = pairIndex.find(name1);
+    if (iter == pairIndex.end() || pairIndex.find(name2) == pairIndex.end() ||
+        pairIndex[name2] != iter->second || contact->count < 1)
+    {
+      ++unexpected;
+      continue;
+    }
+    const SpherePair &pair = _pairs[iter->second];
+    found[iter->second] = true;
+
+    const double depth = 2 * pair.radius - pair.separation;
+    depthError.InsertData((contact->depths[0] - depth) / pair.radius);
+
+    // the normal is undefined for concentric spheres
+    if (pair.separation > 0)
+    {
+      const auto axis = (pair.b->WorldPose().Pos() -
+                         pair.a->WorldPose().Pos()).Normalize();
+      normalError.InsertData(1 - std::abs(contact->normals[0].Dot(axis)));
+    }
+  }
+
+  unsigned int missed = 0;
+  for (size_t i = 0; i < _pairs.size(); ++i)
+  {
+    const bool touching =
+        _pairs[i].separation <= 2 * _pairs[i].radius * (1 + 1e-9);
+    if (touching && !found[i])
+      ++missed;
+    else if (!touching && found[i])
+      ++unexpected;
+  }
+
+  this->Record("contactDepthErr_", depthError);
+  this->Record("contactNormalErr_", normalError);
+  this->Record("missedContacts", missed);
+  this->Record("unexpectedContacts", unexpected);
+}
+
+/////////////////////////////////////////////////
+void CollideFixture::LoadSpheres(const std::string &_physicsEngine
+                               , int _pairCount
+                               , std::vector<SpherePair> &_pairs)
+{
+  ASSERT_GT(_pairCount, 0);
+  if (_pairCount == 24)
+  {
+    Load("worlds/collide_spheres.world", true, _physicsEngine);
+  }
+  else
+  {
+    WorldBuilder builder("collide_spheres");
+    builder.AddModels(SpherePairGrid(_pairCount));
+    const std::string worldFile = builder.WriteTemporary("spheres");
+    ASSERT_FALSE(worldFile.empty());
+    Load(worldFile, true, _physicsEngine);
+    boost::filesystem::remove(worldFile);
+  }
+  physics::WorldPtr world = physics::get_world("collide_spheres");
+  ASSERT_NE(world, nullptr);
+
+  // Verify physics engine type
+  physics::PhysicsEnginePtr physics = world->Physics();
+  ASSERT_NE(physics, nullptr);
+  ASSERT_EQ(physics->GetType(), _physicsEngine);
+
+  // Disable physics updates
+  world->SetPhysicsEnabled(false);
+
+  _pairs = FindSpherePairs(world);
+  ASSERT_EQ(_pairs.size(), static_cast<size_t>(_pairCount));
+  for (const auto &pair : _pairs)
+  {
+    ASSERT_NE(pair.a, nullptr);
+    ASSERT_NE(pair.b, nullptr);
+  }
+}
+
 /////////////////////////////////////////////////
 // Collide spheres:
 // Load world with many pairs of spheres in contact.
 // Disable physics and verify collision checking.
-void CollideTest::Spheres(const std::string &_physicsEngine
-                        , double _dt)
+void CollideFixture::Spheres(const std::string &_physicsEngine
+                           , double _dt)
 {
   // Load collide_spheres world
   Load("worlds/collide_spheres.world", true, _physicsEngine);
@@ -52,93 +228,59 @@ void CollideTest::Spheres(const std::string &_physicsEngine
   world->SetPhysicsEnabled(false);
 
   // Models with 1mm and 100mm radius
-  auto models = world->Models();
-  mapSeparatedModels mmRadius, dmRadius;
-  for (const auto model : models)
-  {
-    const auto name = model->GetName();
-    double radius;
-    if (name.find("mm") == 0)
-    {
-      double separation = std::stod(name.substr(2, 2)) / 10;
-      if (name.at(4) == 'A')
-      {
-        mmRadius[separation].first = model;
-      }
-      else if (name.at(4) == 'B')
-      {
-        mmRadius[separation].second = model;
-      }
-      else
-      {
-        gzerr << "Unrecognized model name: " << name << std::endl;
-      }
-    }
-    else if (name.find("dm") == 0)
-    {
-      double separation = std::stod(name.substr(2, 2)) / 10;
-      if (name.at(4) == 'A')
-      {
-        dmRadius[separation].first = model;
-      }
-      else if (name.at(4) == 'B')
-      {
-        dmRadius[separation].second = model;
-      }
-      else
-      {
-        gzerr << "Unrecognized model name: " << name << std::endl;
-      }
-    }
-  }
-
-  // Confirm no models are missing a partner
-  for (const auto mmPair : mmRadius)
-  {
-    gzdbg << "Checking mm radius pair with separation "
-          << mmPair.first
-          << std::endl;
-    ASSERT_NE(mmPair.second.first, nullptr);
-    ASSERT_NE(mmPair.second.second, nullptr);
-  }
-  for (const auto dmPair : dmRadius)
-  {
-    gzdbg << "Checking dm radius pair with separation "
-          << dmPair.first
-          << std::endl;
-    ASSERT_NE(dmPair.second.first, nullptr);
-    ASSERT_NE(dmPair.second.second, nullptr);
-  }
+  const auto pairs = FindSpherePairs(world);
+  ASSERT_EQ(pairs.size(), 24u);
 
+  // Confirm no models are missing a partner and
   // compute distance between object centers
-  for (const auto mmPair : mmRadius)
+  for (const auto &pair : pairs)
   {
-    auto modelA = mmPair.second.first;
-    auto modelB = mmPair.second.second;
-    auto positionDiff = modelA->WorldPose().Pos()
-                      - modelB->WorldPose().Pos();
-    EXPECT_DOUBLE_EQ(positionDiff.Length(), mmPair.first * 1e-3);
-  }
-  for (const auto dmPair : dmRadius)
-  {
-    auto modelA = dmPair.second.first;
-    auto modelB = dmPair.second.second;
-    auto positionDiff = modelA->WorldPose().Pos()
-                      - modelB->WorldPose().Pos();
-    EXPECT_DOUBLE_EQ(positionDiff.Length(), dmPair.first * 1e-1);
+    gzdbg << "Checking pair with radius " << pair.radius
+          << " and separation " << pair.separation
+          << std::endl;
+    ASSERT_NE(pair.a, nullptr);
+    ASSERT_NE(pair.b, nullptr);
+    auto positionDiff = pair.a->WorldPose().Pos()
+                      - pair.b->WorldPose().Pos();
+    EXPECT_DOUBLE_EQ(positionDiff.Length(), pair.separation);
   }
 
   // You have to subscribe to a contacts topic in order to use
   // the C++ API, otherwise it skips it to save CPU time
   auto contactSub = this->node->Subscribe("~/physics/contacts", &OnContacts);
 
-  world->Step(1);
+  // Optional performance counters of the world update thread, whose id
+  // is known after its first update. With physics disabled, the extra
+  // step does not change the state.
+  PerfCounters counters;
+  bool perfCounters = OptionBool("BENCHMARK_PERF_COUNTERS", false);
+  if (perfCounters)
+  {
+    this->StepWorld(world, 1);
+    perfCounters = counters.Open(this->PhysicsThreadId());
+  }
+  RecordProperty("perfCounters", perfCounters);
+
+  StepTimer stepTimer;
+  MemoryStats memory;
+  memory.Start();
+  counters.Start();
+  stepTimer.Start();
+  this->StepWorld(world, 1);
+  stepTimer.Stop();
+  counters.Stop();
+  memory.Stop(1);
+  this->Record("stepLatency_", stepTimer);
+  this->Record("", memory);
+  if (perfCounters)
+    this->Record("", counters, 1);
 
   // Contact data
   auto contactManager = physics->GetContactManager();
   ASSERT_NE(contactManager, nullptr);
   unsigned int contactCount = contactManager->GetContactCount();
   EXPECT_EQ(contactCount, 16u);
+  EXPECT_EQ(contactCount, ExpectedContactCount(pairs));
   auto contacts = contactManager->GetContacts();
 
   for (unsigned int i = 0; i < contactCount; ++i)
@@ -157,14 +299,417 @@ void CollideTest::Spheres(const std::string &_physicsEngine
   }
 
   // Recording data
-  // // Record statistics on pitch and yaw angles
-  // this->Record("energy0", E0);
-  // this->Record("energyError_", energyError);
-  // this->Record("angMomentum0", H0mag);
-  // this->Record("angMomentumErr_", angularMomentumError.Mag());
-  // this->Record("angPositionErr", angularPositionError);
-  // this->Record("linPositionErr_", linearPositionError.Mag());
-  // this->Record("linVelocityErr_", linearVelocityError.Mag());
+  this->Record("contactCount", contactCount);
+  this->RecordContactErrors(contactManager, pairs);
+
+  // Hash of the contacts, to compare with a reference run
+  if (this->ReplayInterval() > 0)
+  {
+    ReplayLog replay = this->NewReplayLog();
+    replay.Add(1, world);
+    this->FinishReplay(replay);
+  }
+}
+
+/////////////////////////////////////////////////
+// Collide spheres throughput:
+// Load or generate a world with many sphere pairs, disable physics
+// and time repeated collision passes of the physics engine.
+void CollideFixture::SpheresThroughput(const std::string &_physicsEngine
+                                     , int _pairCount
+                                     , int _passes)
+{
+  ASSERT_GT(_passes, 0);
+  std::vector<SpherePair> pairs;
+  ASSERT_NO_FATAL_FAILURE(this->LoadSpheres(_physicsEngine, _pairCount,
+                                            pairs));
+  physics::WorldPtr world = physics::get_world("collide_spheres");
+  physics::PhysicsEnginePtr physics = world->Physics();
+  const unsigned int expectedContacts = ExpectedContactCount(pairs);
+  this->Record("expectedContacts", expectedContacts);
+
+  // You have to subscribe to a contacts topic in order to use
+  // the C++ API, otherwise it skips it to save CPU time
+  auto contactSub = this->node->Subscribe("~/physics/contacts", &OnContacts);
+  auto contactManager = physics->GetContactManager();
+  ASSERT_NE(contactManager, nullptr);
+
+  // A first world update initializes the collision spaces
+  // before the timed passes.
+  this->StepWorld(world, 1);
+
+  // Call the collision pass directly while holding the physics update
+  // mutex, so the timing excludes the rest of the world update.
+  StepTimer passTimer;
+  uint64_t totalContacts = 0;
+  // The passes run on this thread
+  PerfCounters counters;
+  const bool perfCounters =
+      OptionBool("BENCHMARK_PERF_COUNTERS", false) && counters.Open();
+  RecordProperty("perfCounters", perfCounters);
+  MemoryStats memory;
+  memory.Start();
+  counters.Start();
+  for (int i = 0; i < _passes; ++i)
+  {
+    boost::recursive_mutex::scoped_lock lock(
+        *physics->GetPhysicsUpdateMutex());
+    contactManager->ResetCount();
+    passTimer.Start();
+    physics->UpdateCollision();
+    passTimer.Stop();
+    totalContacts += contactManager->GetContactCount();
+  }
+  counters.Stop();
+  memory.Stop(_passes);
+  const unsigned int contactCount = contactManager->GetContactCount();
+  EXPECT_EQ(contactCount, expectedContacts);
+
+  this->Record("contactCount", contactCount);
+  this->Record("passLatency_", passTimer);
+  this->Record("passWallTime", passTimer.Total());
+  this->Record("", memory);
+  if (perfCounters)
+    this->Record("", counters, _passes);
+  this->Record("contactsPerSecond", totalContacts / passTimer.Total());
+  this->Record("pairsPerSecond",
+      static_cast<double>(_pairCount) * _passes / passTimer.Total());
+  this->RecordContactErrors(contactManager, pairs);
+}
+
+/////////////////////////////////////////////////
+// Contact overhead:
+// Time world steps with physics disabled while contacts are dropped,
+// kept for the C++ API only, and published to transport subscribers.
+void CollideFixture::ContactOverhead(const std::string &_physicsEngine
+                                   , int _pairCount
+                                   , int _subscribers)
+{
+  ASSERT_GT(_subscribers, 0);
+  std::vector<SpherePair> pairs;
+  ASSERT_NO_FATAL_FAILURE(this->LoadSpheres(_physicsEngine, _pairCount,
+                                            pairs));
+  physics::WorldPtr world = physics::get_world("collide_spheres");
+  physics::PhysicsEnginePtr physics = world->Physics();
+  auto contactManager = physics->GetContactManager();
+  ASSERT_NE(contactManager, nullptr);
+  const unsigned int expectedContacts = ExpectedContactCount(pairs);
+  this->Record("expectedContacts", expectedContacts);
+
+  const int steps = 500;
+  auto timeSteps = [&](StepTimer &_timer)
+  {
+    for (int i = 0; i < steps; ++i)
+    {
+      _timer.Start();
+      this->StepWorld(world, 1);
+      _timer.Stop();
+    }
+  };
+
+  // No subscribers: the engine skips storing contacts
+  contactManager->SetNeverDropContacts(false);
+  this->StepWorld(world, 1);
+  StepTimer noneTimer;
+  timeSteps(noneTimer);
+  this->Record("noneContactCount", contactManager->GetContactCount());
+  this->Record("noneStepLatency_", noneTimer);
+
+  // C++ API consumer: contacts are stored but not published
+  contactManager->SetNeverDropContacts(true);
+  this->StepWorld(world, 1);
+  StepTimer apiTimer;
+  timeSteps(apiTimer);
+  const unsigned int contactCount = contactManager->GetContactCount();
+  EXPECT_EQ(contactCount, expectedContacts);
+  this->Record("contactCount", contactCount);
+  this->Record("apiStepLatency_", apiTimer);
+  contactManager->SetNeverDropContacts(false);
+
+  // Transport subscribers, each on its own node.
+  // Step until the contact publisher sees the subscriptions.
+  std::vector<transport::NodePtr> nodes;
+  std::vector<transport::SubscriberPtr> subscribers;
+  for (int i = 0; i < _subscribers; ++i)
+  {
+    transport::NodePtr node(new transport::Node());
+    node->Init();
+    subscribers.push_back(node->Subscribe("~/physics/contacts", &OnContacts));
+    nodes.push_back(node);
+  }
+  for (int i = 0; i < 100 && contactManager->GetContactCount() == 0; ++i)
+  {
+    common::Time::MSleep(10);
+    this->StepWorld(world, 1);
+  }
+  EXPECT_EQ(contactManager->GetContactCount(), expectedContacts);
+  StepTimer transportTimer;
+  timeSteps(transportTimer);
+  this->Record("transportStepLatency_", transportTimer);
+
+  // Marginal cost per contact from the median step times,
+  // for storing contacts and for serializing and publishing them.
+  if (contactCount > 0)
+  {
+    const double none = noneTimer.Quantile(0.5);
+    const double api = apiTimer.Quantile(0.5);
+    const double published = transportTimer.Quantile(0.5);
+    this->Record("apiCostPerContact", (api - none) / contactCount);
+    this->Record("transportCostPerContact",
+        (published - api) / contactCount);
+    this->Record("transportCostPerContactSubscriber",
+        (published - api) / contactCount / _subscribers);
+  }
+}
+
+/////////////////////////////////////////////////
+// Contact coherence:
+// Time collision passes with physics disabled while the sphere pairs
+// are static, slightly perturbed every pass, and reshuffled every pass.
+void CollideFixture::ContactCoherence(const std::string &_physicsEngine
+                                    , int _pairCount
+                                    , int _passes)
+{
+  ASSERT_GT(_passes, 0);
+  std::vector<SpherePair> pairs;
+  ASSERT_NO_FATAL_FAILURE(this->LoadSpheres(_physicsEngine, _pairCount,
+                                            pairs));
+  physics::WorldPtr world = physics::get_world("collide_spheres");
+  physics::PhysicsEnginePtr physics = world->Physics();
+  const unsigned int expectedContacts = ExpectedContactCount(pairs);
+  this->Record("expectedContacts", expectedContacts);
+
+  // You have to subscribe to a contacts topic in order to use
+  // the C++ API, otherwise it skips it to save CPU time
+  auto contactSub = this->node->Subscribe("~/physics/contacts", &OnContacts);
+  auto contactManager = physics->GetContactManager();
+  ASSERT_NE(contactManager, nullptr);
+  this->StepWorld(world, 1);
+
+  // Initial position of sphere A of each pair, with sphere B placed
+  // relative to it. The 0.3 m grid spacing of the sphere pairs is enough
+  // that pairs do not touch each other in any of these placements.
+  std::vector<ignition::math::Vector3d> anchors;
+  std::vector<ignition::math::Vector3d> offsets;
+  for (const auto &pair : pairs)
+  {
+    anchors.push_back(pair.a->WorldPose().Pos());
+    offsets.push_back(pair.b->WorldPose().Pos() - anchors.back());
+  }
+  auto placePair = [&](size_t _pair, const ignition::math::Vector3d &_pos)
+  {
+    pairs[_pair].a->SetWorldPose(ignition::math::Pose3d(_pos,
+        ignition::math::Quaterniond::Identity));
+    pairs[_pair].b->SetWorldPose(ignition::math::Pose3d(
+        _pos + offsets[_pair], ignition::math::Quaterniond::Identity));
+  };
+
+  // Fixed seed, so every engine sees the same sequence of placements
+  std::mt19937 random(1234);
+  const double perturbation = 1e-3;
+  std::uniform_real_distribution<double> offset(-perturbation, perturbation);
+  std::vector<size_t> slots(pairs.size());
+  for (size_t i = 0; i < slots.size(); ++i)
+    slots[i] = i;
+
+  const std::vector<std::string> regimes =
+      {"static", "perturbed", "reshuffled"};
+  std::map<std::string, double> passTimes;
+  for (const auto &regime : regimes)
+  {
+    // Move the pairs back and update the collision spaces once
+    // before the timed passes.
+    {
+      boost::recursive_mutex::scoped_lock lock(
+          *physics->GetPhysicsUpdateMutex());
+      for (size_t i = 0; i < pairs.size(); ++i)
+        placePair(i, anchors[i]);
+      contactManager->ResetCount();
+      physics->UpdateCollision();
+    }
+
+    StepTimer passTimer;
+    for (int i = 0; i < _passes; ++i)
+    {
+      boost::recursive_mutex::scoped_lock lock(
+          *physics->GetPhysicsUpdateMutex());
+      if (regime == "perturbed")
+      {
+        for (size_t p = 0; p < pairs.size(); ++p)
+        {
+          placePair(p, anchors[p] + ignition::math::Vector3d(
+              offset(random), offset(random), offset(random)));
+        }
+      }
+      else if (regime == "reshuffled")
+      {
+        std::shuffle(slots.begin(), slots.end(), random);
+        for (size_t p = 0; p < pairs.size(); ++p)
+          placePair(p, anchors[slots[p]]);
+      }
+      contactManager->ResetCount();
+      passTimer.Start();
+      physics->UpdateCollision();
+      passTimer.Stop();
+    }
+    const unsigned int contactCount = contactManager->GetContactCount();
+    EXPECT_EQ(contactCount, expectedContacts) << regime;
+
+    passTimes[regime] = passTimer.Quantile(0.5);
+    this->Record(regime + "ContactCount", contactCount);
+    this->Record(regime + "PassLatency_", passTimer);
+    this->Record(regime + "PassWallTime", passTimer.Total());
+    this->Record(regime + "PairsPerSecond",
+        static_cast<double>(_pairCount) * _passes / passTimer.Total());
+  }
+
+  // Cost of losing temporal coherence relative to a static scene,
+  // from the median pass times
+  if (passTimes["static"] > 0)
+  {
+    this->Record("perturbedCostRatio",
+        passTimes["perturbed"] / passTimes["static"]);
+    this->Record("reshuffledCostRatio",
+        passTimes["reshuffled"] / passTimes["static"]);
+  }
+  this->RecordContactErrors(contactManager, pairs);
+}
+
+/////////////////////////////////////////////////
+// Tunneling:
+// Fire a projectile at a thin wall with a sweep of time step sizes
+// and record which ones let it pass through the wall
+void CollideFixture::Tunneling(const std::string &_physicsEngine
+                             , const std::string &_shape
+                             , double _size
+                             , double _speed)
+{
+  ASSERT_GT(_size, 0.0);
+  ASSERT_GT(_speed, 0.0);
+  const double density = 1000.0;
+  const double wallThickness = 0.01;
+  const double distance = 1.0;
+
+  // static wall centered at the origin, normal to x
+  WorldBuilder builder;
+  builder.SetGravity(ignition::math::Vector3d::Zero);
+  msgs::Model wall;
+  wall.set_name("wall");
+  wall.set_is_static(true);
+  msgs::AddBoxLink(wall, 1.0,
+      ignition::math::Vector3d(wallThickness, 2.0, 2.0));
+  builder.AddModel(wall);
+
+  // projectile moving along +x, with its near face the distance away
+  // from the wall
+  msgs::Model projectile;
+  projectile.set_name("projectile");
+  double halfLength = 0.5 * _size;
+  if (_shape == "sphere")
+  {
+    msgs::AddSphereLink(projectile,
+        density * M_PI / 6.0 * std::pow(_size, 3), 0.5 * _size);
+  }
+  else
+  {
+    ASSERT_EQ(_shape, "box");
+    const ignition::math::Vector3d plate(_size, 0.1, 0.1);
+    msgs::AddBoxLink(projectile,
+        density * plate.X() * plate.Y() * plate.Z(), plate);
+  }
+  const double x0 = -0.5 * wallThickness - distance - halfLength;
+  msgs::Set(projectile.mutable_pose(),
+      ignition::math::Pose3d(x0, 0, 0, 0, 0, 0));
+  builder.AddModel(projectile);
+
+  const std::string worldFile = builder.WriteTemporary("tunneling");
+  ASSERT_FALSE(worldFile.empty());
+  Load(worldFile, true, _physicsEngine);
+  boost::filesystem::remove(worldFile);
+  physics::WorldPtr world = physics::get_world("default");
+  ASSERT_NE(world, nullptr);
+
+  // Verify physics engine type
+  physics::PhysicsEnginePtr physics = world->Physics();
+  ASSERT_NE(physics, nullptr);
+  ASSERT_EQ(physics->GetType(), _physicsEngine);
+
+  physics::ModelPtr model = world->ModelByName("projectile");
+  ASSERT_NE(model, nullptr);
+  physics::LinkPtr link = model->GetLink();
+  ASSERT_NE(link, nullptr);
+  const ignition::math::Vector3d v0(_speed, 0, 0);
+  link->SetLinearVel(v0);
+  ASSERT_EQ(v0, link->WorldCoGLinearVel());
+
+  // long enough to reach the wall and bounce back
+  const double simDuration = 2.0 * distance / _speed + 0.05;
+  this->Record("simDuration", simDuration);
+  WorldSnapshot snapshot;
+  snapshot.Capture(world);
+  physics->SetRealTimeUpdateRate(0.0);
+
+  // time step sizes from small to large
+  const std::vector<double> dts = {1e-4, 2.5e-4, 5e-4, 1e-3, 2e-3, 5e-3};
+  double dtNoTunneling = 0.0;
+  double dtNoTunnelingStepTime = 0.0;
+  bool tunneledBefore = false;
+  for (size_t dtCase = 0; dtCase < dts.size(); ++dtCase)
+  {
+    const double dt = dts[dtCase];
+    this->SetRecordCase(dtCase);
+    this->Record("dt", dt);
+    if (dtCase > 0)
+      EXPECT_TRUE(snapshot.Restore(world));
+    physics->SetMaxStepSize(dt);
+    const int steps = ceil(simDuration / dt);
+
+    // penetration of the leading face of the projectile into the wall,
+    // until its center passes the middle of the wall
+    double maxPenetration = 0.0;
+    bool tunneled = false;
+    StepTimer stepTimer;
+    for (int i = 0; i < steps; ++i)
+    {
+      stepTimer.Start();
+      this->StepWorld(world, 1);
+      stepTimer.Stop();
+      const double x = link->WorldCoGPose().Pos().X();
+      tunneled = x > 0.0;
+      if (!tunneled)
+      {
+        maxPenetration = std::max(maxPenetration,
+            x + halfLength + 0.5 * wallThickness);
+      }
+    }
+
+    const double stepTime = stepTimer.Total() / stepTimer.Count();
+    this->Record("tunneled", tunneled);
+    this->Record("maxPenetration", maxPenetration);
+    this->Record("relativePenetration", maxPenetration / _size);
+    this->Record("finalVelocity", link->WorldCoGLinearVel().X());
+    this->Record("stepTime", stepTime);
+    this->Record("stepLatency_", stepTimer);
+
+    tunneledBefore = tunneledBefore || tunneled;
+    if (!tunneledBefore)
+    {
+      dtNoTunneling = dt;
+      dtNoTunnelingStepTime = stepTime;
+    }
+  }
+  this->SetRecordCase(-1);
+  this->Record("sweepCases", dts.size());
+
+  // Largest time step size without tunneling, 0 if even the smallest
+  // one tunneled, and the cost of simulating a second at that size
+  this->Record("dtNoTunneling", dtNoTunneling);
+  if (dtNoTunneling > 0)
+  {
+    this->Record("dtNoTunnelingStepTime", dtNoTunnelingStepTime);
+    this->Record("dtNoTunnelingTimeRatio",
+        dtNoTunnelingStepTime / dtNoTunneling);
+  }
 }
 
 /////////////////////////////////////////////////
@@ -180,3 +725,79 @@ TEST_P(CollideTest, Spheres)
   Spheres(physicsEngine
         , dt);
 }
+
+/////////////////////////////////////////////////
+TEST_P(CollideThroughputTest, Spheres)
+{
+  std::string physicsEngine = std::tr1::get<0>(GetParam());
+  int pairCount             = std::tr1::get<1>(GetParam());
+  int passes                = std::tr1::get<2>(GetParam());
+  gzdbg << physicsEngine
+        << ", pairCount: " << pairCount
+        << ", passes: " << passes
+        << std::endl;
+  RecordProperty("engine", physicsEngine);
+  this->Record("pairCount", pairCount);
+  this->Record("passes", passes);
+  SpheresThroughput(physicsEngine
+                  , pairCount
+                  , passes);
+}
+
+/////////////////////////////////////////////////
+TEST_P(CollideCoherenceTest, Spheres)
+{
+  std::string physicsEngine = std::tr1::get<0>(GetParam());
+  int pairCount             = std::tr1::get<1>(GetParam());
+  int passes                = std::tr1::get<2>(GetParam());
+  gzdbg << physicsEngine
+        << ", pairs: " << pairCount
+        << ", passes: " << passes
+        << std::endl;
+  RecordProperty("engine", physicsEngine);
+  this->Record("pairCount", pairCount);
+  this->Record("passes", passes);
+  ContactCoherence(physicsEngine
+                 , pairCount
+                 , passes);
+}
+
+/////////////////////////////////////////////////
+TEST_P(CollideTunnelingTest, Tunneling)
+{
+  std::string physicsEngine = std::tr1::get<0>(GetParam());
+  std::string shape         = std::tr1::get<1>(GetParam());
+  double size               = std::tr1::get<2>(GetParam());
+  double speed              = std::tr1::get<3>(GetParam());
+  gzdbg << physicsEngine
+        << ", shape: " << shape
+        << ", size: " << size
+        << ", speed: " << speed
+        << std::endl;
+  RecordProperty("engine", physicsEngine);
+  RecordProperty("shape", shape);
+  this->Record("size", size);
+  this->Record("speed", speed);
+  Tunneling(physicsEngine
+          , shape
+          , size
+          , speed);
+}
+
+/////////////////////////////////////////////////
+TEST_P(CollideContactsTest, Spheres)
+{
+  std::string physicsEngine = std::tr1::get<0>(GetParam());
+  int pairCount             = std::tr1::get<1>(GetParam());
+  int subscribers           = std::tr1::get<2>(GetParam());
+  gzdbg << physicsEngine
+        << ", pairCount: " << pairCount
+        << ", subscribers: " << subscribers
+        << std::endl;
+  RecordProperty("engine", physicsEngine);
+  this->Record("pairCount", pairCount);
+  this->Record("subscribers", subscribers);
+  ContactOverhead(physicsEngine
+                , pairCount
+                , subscribers);
+}
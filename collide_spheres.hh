@@ -19,25 +19,171 @@
 #define BENCHMARK_GAZEBO_COLLIDE_SPHERES_HH_
 
 #include <string>
-#include "gazebo/test/ServerFixture.hh"
+#include <vector>
+#include "benchmark_fixture.hh"
 
 namespace gazebo
 {
   namespace benchmark
   {
+    /// \brief Two spheres of equal radius and the distance between
+    /// their centers, decoded from model names such as mm19A and mm19B
+    /// (1mm radius, separation 1.9 radii) or dm05A_3 and dm05B_3
+    /// (100mm radius, separation 0.5 radii, generated copy 3).
+    struct SpherePair
+    {
+      /// \brief Sphere with suffix A.
+      physics::ModelPtr a;
+
+      /// \brief Sphere with suffix B.
+      physics::ModelPtr b;
+
+      /// \brief Radius of both spheres.
+      double radius = 0.0;
+
+      /// \brief Distance between the sphere centers.
+      double separation = 0.0;
+    };
+
+    /// \brief Fixture for collision checking between pairs of spheres
+    /// whose analytic separation is encoded in the model names.
+    class CollideFixture : public BenchmarkFixture
+    {
+      /// \brief Test collision checking between spheres.
+      /// \param[in] _physicsEngine Physics engine to use.
+      /// \param[in] _dt Max time step size.
+      public: void Spheres(const std::string &_physicsEngine
+                         , double _dt);
+
+      /// \brief Measure collision checking throughput by repeating the
+      /// collision pass with physics disabled, and record contacts
+      /// per second, per-pass latency and contact depth and normal errors.
+      /// \param[in] _physicsEngine Physics engine to use.
+      /// \param[in] _pairCount Number of sphere pairs. With 24 pairs the
+      /// collide_spheres world is loaded, otherwise copies of its pairs
+      /// are generated.
+      /// \param[in] _passes Number of timed collision passes.
+      public: void SpheresThroughput(const std::string &_physicsEngine
+                                   , int _pairCount
+                                   , int _passes);
+
+      /// \brief Measure the step time with physics disabled when contacts
+      /// are dropped (no subscribers), kept for the C++ API only
+      /// (ContactManager::SetNeverDropContacts), or published to
+      /// transport subscribers, and record the marginal cost per contact.
+      /// \param[in] _physicsEngine Physics engine to use.
+      /// \param[in] _pairCount Number of sphere pairs, see
+      /// SpheresThroughput.
+      /// \param[in] _subscribers Number of transport subscribers.
+      public: void ContactOverhead(const std::string &_physicsEngine
+                                 , int _pairCount
+                                 , int _subscribers);
+
+      /// \brief Measure the temporal coherence of the collision pass by
+      /// timing collision passes (as in SpheresThroughput) while the
+      /// sphere pairs are held static, translated by a small random
+      /// offset before each pass, and moved to a random permutation of
+      /// the pair positions before each pass. Pairs are moved rigidly,
+      /// so the analytic contacts are the same in every regime and only
+      /// the cost of the broadphase and cached contact data changes.
+      /// \param[in] _physicsEngine Physics engine to use.
+      /// \param[in] _pairCount Number of sphere pairs, see
+      /// SpheresThroughput.
+      /// \param[in] _passes Number of timed collision passes per regime.
+      public: void ContactCoherence(const std::string &_physicsEngine
+                                  , int _pairCount
+                                  , int _passes);
+
+      /// \brief Fire a small fast projectile at a thin static wall with
+      /// gravity off, over a sweep of time step sizes recorded as separate
+      /// cases, and detect tunneling from the final position: the
+      /// projectile tunneled if its center ends past the middle of the
+      /// wall. Records the largest time step size without tunneling at
+      /// that and every smaller time step size, and its step cost.
+      /// \param[in] _physicsEngine Physics engine to use.
+      /// \param[in] _shape Projectile shape, sphere (diameter _size) or
+      /// box (a plate _size thick along the direction of motion).
+      /// \param[in] _size Projectile size.
+      /// \param[in] _speed Initial speed towards the wall.
+      public: void Tunneling(const std::string &_physicsEngine
+                           , const std::string &_shape
+                           , double _size
+                           , double _speed);
+
+      /// \brief Load collide_spheres.world (24 pairs) or a generated
+      /// world with copies of its sphere pairs, and disable physics.
+      /// \param[in] _physicsEngine Physics engine to use.
+      /// \param[in] _pairCount Number of sphere pairs.
+      /// \param[out] _pairs Sphere pairs of the loaded world.
+      protected: void LoadSpheres(const std::string &_physicsEngine
+                                , int _pairCount
+                                , std::vector<SpherePair> &_pairs);
+
+      /// \brief Compare the current contacts against the analytic contact
+      /// of each pair and record the maximum depth error (relative to the
+      /// radius), normal error (1 - |cos| of the angle from the line
+      /// between centers) and the number of missed and unexpected contacts.
+      /// \param[in] _contactManager Contact manager of the world.
+      /// \param[in] _pairs Sphere pairs of the world.
+      protected: void RecordContactErrors(
+                     physics::ContactManager *_contactManager,
+                     const std::vector<SpherePair> &_pairs);
+    };
+
     // physics engine
     // dt
     typedef std::tr1::tuple < const char *
                             , double
                             > char1double1;
-    class CollideTest : public ServerFixture,
+    class CollideTest : public CollideFixture,
                         public testing::WithParamInterface<char1double1>
     {
-      /// \brief Test collision checking between spheres.
-      /// \param[in] _physicsEngine Physics engine to use.
-      /// \param[in] _dt Max time step size.
-      public: void Spheres(const std::string &_physicsEngine
-                         , double _dt);
+    };
+
+    // physics engine
+    // number of sphere pairs
+    // number of collision passes
+    typedef std::tr1::tuple < const char *
+                            , int
+                            , int
+                            > char1int2;
+    /// \brief Collision throughput with a scaled number of sphere pairs.
+    class CollideThroughputTest : public CollideFixture,
+        public testing::WithParamInterface<char1int2>
+    {
+    };
+
+    // physics engine
+    // projectile shape
+    // projectile size
+    // projectile speed
+    typedef std::tr1::tuple < const char *
+                            , const char *
+                            , double
+                            , double
+                            > char2double2;
+    /// \brief Tunneling of fast projectiles through a thin wall.
+    class CollideTunnelingTest : public CollideFixture,
+        public testing::WithParamInterface<char2double2>
+    {
+    };
+
+    // physics engine
+    // number of sphere pairs
+    // number of collision passes per regime
+    /// \brief Collision cost of static, perturbed and reshuffled pairs.
+    class CollideCoherenceTest : public CollideFixture,
+        public testing::WithParamInterface<char1int2>
+    {
+    };
+
+    // physics engine
+    // number of sphere pairs
+    // number of transport subscribers
+    /// \brief Contact storage and publishing overhead.
+    class CollideContactsTest : public CollideFixture,
+        public testing::WithParamInterface<char1int2>
+    {
     };
   }
 }
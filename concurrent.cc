@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <errno.h>
+#include <poll.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "gazebo/gazebo.hh"
+#include "gazebo/physics/physics.hh"
+#include "benchmark_options.hh"
+#include "concurrent.hh"
+#include "cpu_affinity.hh"
+#include "trial_stats.hh"
+#include "world_builder.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+typedef StepTimer::Clock clock;
+
+/////////////////////////////////////////////////
+// Result of one world, written by its child process to a pipe.
+struct WorldResult
+{
+  /// \brief Seconds to set up the server and load the world.
+  double loadTime;
+
+  /// \brief Seconds spent stepping.
+  double stepTime;
+
+  /// \brief Simulated seconds.
+  double simTime;
+
+  /// \brief 1 if the world was loaded and stepped.
+  int ok;
+};
+
+/////////////////////////////////////////////////
+// Seconds elapsed between two time points.
+static double Seconds(const clock::time_point &_start,
+                      const clock::time_point &_end)
+{
+  return std::chrono::duration<double>(_end - _start).count();
+}
+
+/////////////////////////////////////////////////
+// Child process of one world: load it, signal readiness, wait for the
+// start signal, step it and write the result. Never returns.
+static void RunWorld(const std::string &_worldSdf, int _port, int _cpu,
+                     double _simDuration, int _readyFd, int _goFd,
+                     int _resultFd)
+{
+  setenv("GAZEBO_MASTER_URI",
+      ("http://localhost:" + std::to_string(_port)).c_str(), 1);
+  SetThreadAffinity(std::to_string(_cpu));
+
+  WorldResult result = {0.0, 0.0, 0.0, 0};
+  const clock::time_point loadStart = clock::now();
+  physics::WorldPtr world;
+  if (gazebo::setupServer())
+    world = LoadWorldSdf(_worldSdf);
+  result.loadTime = Seconds(loadStart, clock::now());
+
+  char byte = 1;
+  if (write(_readyFd, &byte, 1) != 1 || read(_goFd, &byte, 1) != 1)
+    _exit(1);
+
+  if (world)
+  {
+    const double dt = world->Physics()->GetMaxStepSize();
+    const int steps = ceil(_simDuration / dt);
+    const common::Time t0 = world->SimTime();
+    const clock::time_point stepStart = clock::now();
+    gazebo::runWorld(world, steps);
+    result.stepTime = Seconds(stepStart, clock::now());
+    result.simTime = (world->SimTime() - t0).Double();
+    result.ok = 1;
+  }
+  const bool written =
+      write(_resultFd, &result, sizeof(result)) == sizeof(result);
+  // skip the destructors and atexit handlers of the parent's state
+  _exit(written ? 0 : 1);
+}
+
+/////////////////////////////////////////////////
+// Worlds:
+// Run increasing numbers of independent worlds at the same time and
+// record the aggregate simulation rate
+void ConcurrentFixture::Worlds(const std::string &_physicsEngine
+                             , const std::string &_scene)
+{
+  const std::string worldSdf = SceneSdf(_scene, _physicsEngine);
+  ASSERT_FALSE(worldSdf.empty());
+
+  // one world per core available to the test by default
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  ASSERT_EQ(sched_getaffinity(0, sizeof(cpuSet), &cpuSet), 0);
+  std::vector<int> cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+  {
+    if (CPU_ISSET(cpu, &cpuSet))
+      cpus.push_back(cpu);
+  }
+  const int maxWorlds = std::max(1, OptionInt("BENCHMARK_MAX_WORLDS",
+      static_cast<int>(cpus.size())));
+  const int basePort = OptionInt("BENCHMARK_WORLD_BASE_PORT", 12345);
+  const double loadTimeout = OptionDouble("BENCHMARK_WORLD_LOAD_TIMEOUT",
+      120.0);
+  const double simDuration = 2.0;
+  this->Record("maxWorlds", maxWorlds);
+  this->Record("simDuration", simDuration);
+
+  std::vector<int> worldCounts;
+  for (int m = 1; m < maxWorlds; m *= 2)
+    worldCounts.push_back(m);
+  worldCounts.push_back(maxWorlds);
+
+  double singleRate = 0.0;
+  for (size_t c = 0; c < worldCounts.size(); ++c)
+  {
+    const int worlds = worldCounts[c];
+    this->SetRecordCase(c);
+    this->Record("worlds", worlds);
+
+    int readyPipe[2], goPipe[2], resultPipe[2];
+    ASSERT_EQ(pipe(readyPipe), 0);
+    ASSERT_EQ(pipe(goPipe), 0);
+    ASSERT_EQ(pipe(resultPipe), 0);
+    std::vector<pid_t> children;
+    for (int i = 0; i < worlds; ++i)
+    {
+      const pid_t pid = fork();
+      if (pid == 0)
+      {
+        close(readyPipe[0]);
+        close(goPipe[1]);
+        close(resultPipe[0]);
+        RunWorld(worldSdf, basePort + i, cpus[i % cpus.size()],
+            simDuration, readyPipe[1], goPipe[0], resultPipe[1]);
+      }
+      EXPECT_GT(pid, 0);
+      if (pid > 0)
+        children.push_back(pid);
+    }
+    close(readyPipe[1]);
+    close(goPipe[0]);
+    close(resultPipe[1]);
+
+    // start stepping every world at once after all are loaded; children
+    // that exit before they are ready are reaped while waiting, and those
+    // not ready after loadTimeout are killed
+    int ready = 0;
+    char byte = 1;
+    std::vector<bool> exited(children.size(), false);
+    int exitedCount = 0;
+    const clock::time_point loadStart = clock::now();
+    while (ready + exitedCount < static_cast<int>(children.size()))
+    {
+      struct pollfd readyPoll = {readyPipe[0], POLLIN, 0};
+      const int polled = poll(&readyPoll, 1, 1000);
+      if (polled > 0 && (readyPoll.revents & POLLIN))
+      {
+        if (read(readyPipe[0], &byte, 1) == 1)
+          ++ready;
+        continue;
+      }
+      if (polled < 0 && errno != EINTR)
+        break;
+      for (size_t i = 0; i < children.size(); ++i)
+      {
+        if (!exited[i] && waitpid(children[i], nullptr, WNOHANG) ==
+            children[i])
+        {
+          exited[i] = true;
+          ++exitedCount;
+        }
+      }
+      if (Seconds(loadStart, clock::now()) > loadTimeout)
+      {
+        ADD_FAILURE() << ready << " of " << worlds
+                      << " worlds ready after " << loadTimeout << " s";
+        for (size_t i = 0; i < children.size(); ++i)
+        {
+          if (!exited[i])
+            kill(children[i], SIGKILL);
+        }
+        break;
+      }
+    }
+    const clock::time_point start = clock::now();
+    for (int i = 0; i < ready; ++i)
+      EXPECT_EQ(write(goPipe[1], &byte, 1), 1);
+
+    TrialStats loadTimes;
+    TrialStats stepTimes;
+    double simTime = 0.0;
+    int done = 0;
+    WorldResult result;
+    while (read(resultPipe[0], &result, sizeof(result)) == sizeof(result))
+    {
+      if (!result.ok)
+        continue;
+      ++done;
+      loadTimes.Insert(result.loadTime);
+      stepTimes.Insert(result.stepTime);
+      simTime += result.simTime;
+    }
+    const double wallTime = Seconds(start, clock::now());
+    close(readyPipe[0]);
+    close(goPipe[1]);
+    close(resultPipe[0]);
+    for (size_t i = 0; i < children.size(); ++i)
+    {
+      if (!exited[i])
+        waitpid(children[i], nullptr, 0);
+    }
+    EXPECT_EQ(done, worlds);
+
+    // Aggregate simulated seconds per wall second over every world, and
+    // its scaling relative to one world
+    const double rate = simTime / wallTime;
+    if (worlds == 1)
+      singleRate = rate;
+    this->Record("failedWorlds", worlds - done);
+    this->Record("wallTime", wallTime);
+    this->Record("aggregateRealTimeFactor", rate);
+    if (singleRate > 0)
+      this->Record("scalingEfficiency", rate / (worlds * singleRate));
+    this->Record("worldLoadTime_", loadTimes);
+    this->Record("worldStepTime_", stepTimes);
+  }
+  this->SetRecordCase(-1);
+  this->Record("cases", worldCounts.size());
+}
+
+/////////////////////////////////////////////////
+TEST_P(ConcurrentTest, Worlds)
+{
+  std::string physicsEngine = std::tr1::get<0>(GetParam());
+  std::string scene         = std::tr1::get<1>(GetParam());
+  gzdbg << physicsEngine
+        << ", scene: " << scene
+        << std::endl;
+  RecordProperty("engine", physicsEngine);
+  RecordProperty("scene", scene);
+  Worlds(physicsEngine
+       , scene);
+}
@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef BENCHMARK_GAZEBO_CONCURRENT_HH_
+#define BENCHMARK_GAZEBO_CONCURRENT_HH_
+
+#include <string>
+#include "benchmark_fixture.hh"
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Fixture that runs independent copies of a small world
+    /// concurrently, one per child process, as for many short rollouts.
+    class ConcurrentFixture : public BenchmarkFixture
+    {
+      /// \brief Run 1, 2, 4, ... copies of a generated scene at the same
+      /// time, up to the number of cores, each in its own forked process
+      /// with its own in-process gazebo master and pinned to its own core.
+      /// Each count of copies is recorded as a separate case with the
+      /// aggregate simulated seconds per wall second and the scaling
+      /// efficiency relative to a single copy.
+      /// \param[in] _physicsEngine Physics engine to use.
+      /// \param[in] _scene Generated scene, see WriteScene.
+      public: void Worlds(const std::string &_physicsEngine
+                        , const std::string &_scene);
+    };
+
+    // physics engine
+    // generated scene
+    typedef std::tr1::tuple < const char *
+                            , const char *
+                            > char2;
+    class ConcurrentTest : public ConcurrentFixture,
+                           public testing::WithParamInterface<char2>
+    {
+    };
+  }
+}
+#endif
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "cpu_affinity.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+// Parse a core list such as "0-3,8" into a cpu set.
+static bool ParseCpuList(const std::string &_cpus, cpu_set_t &_set)
+{
+  CPU_ZERO(&_set);
+  std::stringstream ss(_cpus);
+  std::string range;
+  int count = 0;
+  while (std::getline(ss, range, ','))
+  {
+    int first, last;
+    char dash;
+    std::stringstream rs(range);
+    if (!(rs >> first))
+      return false;
+    last = first;
+    if (rs >> dash)
+    {
+      if (dash != '-' || !(rs >> last))
+        return false;
+    }
+    if (first < 0 || last < first || last >= CPU_SETSIZE)
+      return false;
+    for (int cpu = first; cpu <= last; ++cpu)
+    {
+      CPU_SET(cpu, &_set);
+      ++count;
+    }
+  }
+  return count > 0;
+}
+
+/////////////////////////////////////////////////
+bool benchmark::SetThreadAffinity(const std::string &_cpus)
+{
+  cpu_set_t set;
+  if (!ParseCpuList(_cpus, set))
+    return false;
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+/////////////////////////////////////////////////
+bool benchmark::SetThreadRealtimePriority(int _priority)
+{
+  sched_param param;
+  param.sched_priority = _priority;
+  return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+
+/////////////////////////////////////////////////
+std::string benchmark::ThreadAffinityMask()
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+    return "";
+
+  int last = 0;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+  {
+    if (CPU_ISSET(cpu, &set))
+      last = cpu;
+  }
+
+  // print 4 cores per hexadecimal digit, most significant first
+  std::string mask;
+  for (int nibble = last / 4; nibble >= 0; --nibble)
+  {
+    int digit = 0;
+    for (int bit = 0; bit < 4; ++bit)
+    {
+      if (CPU_ISSET(nibble * 4 + bit, &set))
+        digit |= 1 << bit;
+    }
+    mask += "0123456789abcdef"[digit];
+  }
+  return "0x" + mask;
+}
+
+/////////////////////////////////////////////////
+std::string benchmark::CpuModel()
+{
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(cpuinfo, line))
+  {
+    if (line.compare(0, 10, "model name") != 0)
+      continue;
+    const size_t colon = line.find(':');
+    if (colon == std::string::npos)
+      continue;
+    std::string model = line.substr(line.find_first_not_of(" \t", colon + 1));
+    std::replace(model.begin(), model.end(), ',', ';');
+    return model;
+  }
+  return "unknown";
+}
+
+/////////////////////////////////////////////////
+std::string benchmark::CpuGovernor(int _cpu)
+{
+  std::ifstream governor("/sys/devices/system/cpu/cpu" + std::to_string(_cpu)
+      + "/cpufreq/scaling_governor");
+  std::string name;
+  if (!(governor >> name))
+    return "unknown";
+  return name;
+}
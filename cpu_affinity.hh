@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_CPU_AFFINITY_HH_
+#define BENCHMARK_GAZEBO_CPU_AFFINITY_HH_
+
+#include <string>
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Pin the calling thread to a set of cores.
+    /// Threads created afterwards by the calling thread inherit the
+    /// affinity.
+    /// \param[in] _cpus Core list such as "2" or "0-3,8".
+    /// \return True if the list was valid and the affinity was set.
+    bool SetThreadAffinity(const std::string &_cpus);
+
+    /// \brief Give the calling thread a SCHED_FIFO real-time priority.
+    /// This usually requires CAP_SYS_NICE.
+    /// \param[in] _priority Priority between 1 and 99.
+    /// \return True if the priority was set.
+    bool SetThreadRealtimePriority(int _priority);
+
+    /// \brief Affinity mask of the calling thread.
+    /// \return Hexadecimal mask such as "0x0f", or an empty string on error.
+    std::string ThreadAffinityMask();
+
+    /// \brief CPU model name from /proc/cpuinfo, with commas replaced
+    /// so it can be stored in a csv column.
+    /// \return Model name, or "unknown".
+    std::string CpuModel();
+
+    /// \brief Frequency scaling governor of a core.
+    /// \param[in] _cpu Core index.
+    /// \return Governor name such as "performance", or "unknown".
+    std::string CpuGovernor(int _cpu = 0);
+  }
+}
+#endif
@@ -1,6 +1,12 @@
 import csv
+import numbers
 import numpy as np
 
+try:
+    stringTypes = (str, unicode)
+except NameError:
+    stringTypes = (str,)
+
 # function for exact matching or partial string matching
 # used for selecting specific test cases based on test parameters
 def match(a,b):
@@ -14,25 +20,75 @@ def match(a,b):
             return False
     return False
 
+# convert the values of one column to a float64 array, with NaN for
+# empty values, or to an array of strings if any value is not a number
+def columnArray(values):
+    try:
+        return np.array(values, dtype=float)
+    except (TypeError, ValueError):
+        pass
+    present = [v for v in values if v not in ('', None)]
+    if present and len(present) < len(values):
+        try:
+            return np.array([v if v not in ('', None) else 'nan'
+                             for v in values], dtype=float)
+        except (TypeError, ValueError):
+            pass
+    return np.array(['' if v is None else v for v in values], dtype=object)
+
 # open data file as csv and construct dictionary of arrays
+# all rows are read first and each column is converted at once
 def makeCsvDictOfArrays(filename):
     with open(filename, 'rt') as csvfile:
-        spamreader = csv.DictReader(csvfile)
-        csvDict = {}
-        for field in spamreader.fieldnames:
-            csvDict[field] = []
-        csvDict[None] = []
-        for row in spamreader:
-            for k in row.keys():
-                try:
-                    csvDict[k] = np.append(csvDict[k], float(row[k]))
-                except:
-                    csvDict[k].append(row[k])
-        return csvDict
+        reader = csv.reader(csvfile)
+        try:
+            fieldnames = next(reader)
+        except StopIteration:
+            return {None: []}
+        rows = list(reader)
+    width = len(fieldnames)
+    csvDict = {}
+    # fields beyond the header, one list per row that has them
+    csvDict[None] = [row[width:] for row in rows if len(row) > width]
+    columns = [[] for _ in fieldnames]
+    for row in rows:
+        if len(row) < width:
+            row = row + [None] * (width - len(row))
+        for column, value in zip(columns, row):
+            column.append(value)
+    for field, column in zip(fieldnames, columns):
+        csvDict[field] = columnArray(column)
+    return csvDict
+
+# boolean array of the rows of a dictionary of arrays whose column
+# matches a value like match(), or for which a predicate that takes
+# the whole column returns true, such as lambda dt: dt < 1e-3
+def matchMask(column, value):
+    if callable(value):
+        return np.asarray(value(column), dtype=bool)
+    column = np.asarray(column)
+    if column.dtype != object:
+        if isinstance(value, numbers.Number):
+            return column == value
+        return np.zeros(column.shape, dtype=bool)
+    if isinstance(value, stringTypes):
+        return np.char.find(column.astype(str), value) >= 0
+    return np.array([x == value for x in column], dtype=bool)
 
 # query a dictionary of arrays for indices of matching parameters
-def query(d, params):
-    result = []
+# the values of params are matched with matchMask
+def queryMask(d, params):
+    mask = None
     for k in params:
-        result.append(set([i for i,x in enumerate(d[k]) if match(params[k], x)]))
-    return sorted(set.intersection(*result))
+        m = matchMask(d[k], params[k])
+        mask = m if mask is None else mask & m
+    return mask
+
+def query(d, params):
+    return np.flatnonzero(queryMask(d, params))
+
+# dictionary of arrays with only the rows at the given indices
+# or boolean mask, such as the result of query or queryMask
+def select(d, rows):
+    return dict((k, np.asarray(v)[rows]) for k, v in d.items()
+                if k is not None)
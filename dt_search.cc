@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <algorithm>
+#include <cmath>
+
+#include "dt_search.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+DtSearch::DtSearch(double _min, double _max, int _iterations)
+  : min(std::min(_min, _max)), current(_max),
+    iterations(std::max(0, _iterations))
+{
+  this->done = !(this->current > 0.0);
+}
+
+/////////////////////////////////////////////////
+bool DtSearch::Done() const
+{
+  return this->done;
+}
+
+/////////////////////////////////////////////////
+double DtSearch::Current() const
+{
+  return this->current;
+}
+
+/////////////////////////////////////////////////
+void DtSearch::Report(bool _withinBudget)
+{
+  if (this->done)
+    return;
+
+  if (_withinBudget)
+    this->lower = this->current;
+  else
+    this->upper = this->current;
+
+  if (this->lower > 0.0 && this->upper <= 0.0)
+  {
+    // the largest step size is within budget
+    this->done = true;
+  }
+  else if (this->lower <= 0.0)
+  {
+    // try the smallest step size next, unless it already failed
+    if (this->current <= this->min || !(this->min > 0.0))
+      this->done = true;
+    else
+      this->current = this->min;
+  }
+  else if (this->iterations-- > 0)
+  {
+    this->current = std::sqrt(this->lower * this->upper);
+  }
+  else
+  {
+    this->done = true;
+  }
+}
+
+/////////////////////////////////////////////////
+double DtSearch::Best() const
+{
+  return this->lower;
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef BENCHMARK_GAZEBO_DT_SEARCH_HH_
+#define BENCHMARK_GAZEBO_DT_SEARCH_HH_
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Search for the largest time step size whose errors are
+    /// within a budget, assuming the errors grow with the step size.
+    /// The largest and smallest step sizes are tried first, then the
+    /// interval between the largest passing and smallest failing step
+    /// sizes is bisected in log space.
+    class DtSearch
+    {
+      /// \brief Constructor.
+      /// \param[in] _min Smallest time step size to try.
+      /// \param[in] _max Largest time step size to try.
+      /// \param[in] _iterations Number of bisection steps after the
+      /// bounds have been tried.
+      public: DtSearch(double _min, double _max, int _iterations);
+
+      /// \brief True when no more step sizes need to be tried.
+      public: bool Done() const;
+
+      /// \brief Time step size to try next.
+      public: double Current() const;
+
+      /// \brief Report the result of the current time step size
+      /// and advance the search.
+      /// \param[in] _withinBudget True if the errors were within budget.
+      public: void Report(bool _withinBudget);
+
+      /// \brief Largest time step size found within budget,
+      /// or 0 if even the smallest one exceeded it.
+      public: double Best() const;
+
+      /// \brief Largest step size within budget so far, 0 if none.
+      private: double lower = 0.0;
+
+      /// \brief Smallest step size over budget so far, 0 if none.
+      private: double upper = 0.0;
+
+      /// \brief Smallest time step size to try.
+      private: double min;
+
+      /// \brief Step size to try next.
+      private: double current;
+
+      /// \brief Remaining bisection steps.
+      private: int iterations;
+
+      /// \brief True when the search is finished.
+      private: bool done = false;
+    };
+  }
+}
+#endif
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <cmath>
+#include <string>
+
+#include <ignition/math/SignalStats.hh>
+#include <ignition/math/Vector3.hh>
+#include <ignition/math/Vector3Stats.hh>
+
+#include "gazebo/physics/physics.hh"
+#include "dzhanibekov.hh"
+#include "step_timer.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+// Dzhanibekov:
+// Spin a body about its intermediate axis with a small perturbation
+// and record accuracy for momentum and energy conservation
+void DzhanibekovFixture::Dzhanibekov(const std::string &_physicsEngine
+                                   , double _dt)
+{
+  physics::WorldPtr world;
+  ASSERT_NO_FATAL_FAILURE(this->LoadPhysicsWorld("worlds/dzhanibekov.world",
+      _physicsEngine, world));
+  physics::PhysicsEnginePtr physics = world->Physics();
+
+  // The body is nested in the model that holds the initial velocity plugin
+  physics::LinkPtr link = boost::dynamic_pointer_cast<physics::Link>(
+      world->EntityByName("dzhanibekov_parent::dzhanibekov::link"));
+  ASSERT_NE(link, nullptr);
+
+  // Same initial conditions as the InitialVelocityPlugin of the world,
+  // set on the link since not every engine applies model velocities
+  // to nested models.
+  const ignition::math::Vector3d w0(10.0, 0.0, 1.0e-10);
+  link->SetLinearVel(ignition::math::Vector3d::Zero);
+  link->SetAngularVel(w0);
+  ASSERT_EQ(w0, link->WorldAngularVel());
+  ASSERT_EQ(world->Gravity(), ignition::math::Vector3d::Zero);
+
+  // initial energy and angular momentum in global frame
+  const double E0 = link->GetWorldEnergy();
+  const ignition::math::Vector3d H0 = link->WorldAngularMomentum();
+  const double H0mag = H0.Length();
+  ASSERT_GT(E0, 0.0);
+  ASSERT_GT(H0mag, 0.0);
+
+  // change step size after setting initial conditions
+  // since simbody requires a time step
+  physics->SetMaxStepSize(_dt);
+  const double simDuration = 10.0;
+  const int steps = ceil(simDuration / _dt);
+
+  // variables to compute statistics on
+  ignition::math::Vector3Stats angularMomentumError;
+  ignition::math::SignalStats energyError;
+  {
+    const std::string statNames = "maxAbs";
+    EXPECT_TRUE(angularMomentumError.InsertStatistics(statNames));
+    EXPECT_TRUE(energyError.InsertStatistics(statNames));
+  }
+
+  // unthrottle update rate
+  physics->SetRealTimeUpdateRate(0.0);
+  StepTimer stepTimer;
+  const common::Time t0 = world->SimTime();
+  const common::Time startTime = common::Time::GetWallTime();
+  for (int i = 0; i < steps; ++i)
+  {
+    stepTimer.Start();
+    this->StepWorld(world, 1);
+    stepTimer.Stop();
+
+    const ignition::math::Vector3d H = link->WorldAngularMomentum();
+    angularMomentumError.InsertData((H - H0) / H0mag);
+    energyError.InsertData((link->GetWorldEnergy() - E0) / E0);
+  }
+  const common::Time elapsedTime = common::Time::GetWallTime() - startTime;
+  const common::Time simTime = world->SimTime() - t0;
+  ASSERT_NEAR(simTime.Double(), simDuration, _dt*1.1);
+
+  this->RecordStepTimes(stepTimer, elapsedTime, simTime);
+
+  this->Record("energy0", E0);
+  this->Record("energyError_", energyError);
+  this->Record("angMomentum0", H0mag);
+  this->Record("angMomentumErr_", angularMomentumError.Mag());
+}
+
+/////////////////////////////////////////////////
+TEST_P(DzhanibekovTest, Dzhanibekov)
+{
+  std::string physicsEngine = std::tr1::get<0>(GetParam());
+  double dt                 = std::tr1::get<1>(GetParam());
+  gzdbg << physicsEngine
+        << ", dt: " << dt
+        << std::endl;
+  RecordProperty("engine", physicsEngine);
+  this->Record("dt", dt);
+  Dzhanibekov(physicsEngine
+            , dt);
+}
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+
+#include "memory_stats.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+// Counters are updated from inside malloc, so they must be usable
+// before static constructors run.
+static std::atomic<bool> g_counting(false);
+static std::atomic<uint64_t> g_allocationCount(0);
+static std::atomic<uint64_t> g_allocatedBytes(0);
+
+/////////////////////////////////////////////////
+static inline void CountAllocation(size_t _size)
+{
+  if (g_counting.load(std::memory_order_relaxed))
+  {
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(_size, std::memory_order_relaxed);
+  }
+}
+
+#ifdef __GLIBC__
+// Interpose the glibc allocator for the whole process,
+// including the physics engine libraries.
+extern "C"
+{
+  void *__libc_malloc(size_t _size);
+  void *__libc_calloc(size_t _count, size_t _size);
+  void *__libc_realloc(void *_ptr, size_t _size);
+  void *__libc_memalign(size_t _alignment, size_t _size);
+  void __libc_free(void *_ptr);
+
+  /////////////////////////////////////////////////
+  void *malloc(size_t _size)
+  {
+    CountAllocation(_size);
+    return __libc_malloc(_size);
+  }
+
+  /////////////////////////////////////////////////
+  void *calloc(size_t _count, size_t _size)
+  {
+    CountAllocation(_count * _size);
+    return __libc_calloc(_count, _size);
+  }
+
+  /////////////////////////////////////////////////
+  void *realloc(void *_ptr, size_t _size)
+  {
+    CountAllocation(_size);
+    return __libc_realloc(_ptr, _size);
+  }
+
+  /////////////////////////////////////////////////
+  void *memalign(size_t _alignment, size_t _size)
+  {
+    CountAllocation(_size);
+    return __libc_memalign(_alignment, _size);
+  }
+
+  /////////////////////////////////////////////////
+  void *aligned_alloc(size_t _alignment, size_t _size)
+  {
+    CountAllocation(_size);
+    return __libc_memalign(_alignment, _size);
+  }
+
+  /////////////////////////////////////////////////
+  int posix_memalign(void **_ptr, size_t _alignment, size_t _size)
+  {
+    if (_alignment % sizeof(void *) != 0 ||
+        (_alignment & (_alignment - 1)) != 0)
+    {
+      return EINVAL;
+    }
+    CountAllocation(_size);
+    void *ptr = __libc_memalign(_alignment, _size);
+    if (!ptr)
+      return ENOMEM;
+    *_ptr = ptr;
+    return 0;
+  }
+
+  /////////////////////////////////////////////////
+  void free(void *_ptr)
+  {
+    __libc_free(_ptr);
+  }
+}
+static const bool kAllocationHook = true;
+#else
+static const bool kAllocationHook = false;
+#endif
+
+/////////////////////////////////////////////////
+uint64_t gazebo::benchmark::ResidentSetSize()
+{
+  std::ifstream statm("/proc/self/statm");
+  uint64_t size = 0;
+  uint64_t resident = 0;
+  if (!(statm >> size >> resident))
+    return 0;
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+/////////////////////////////////////////////////
+uint64_t gazebo::benchmark::PeakResidentSetSize()
+{
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+  {
+    if (line.compare(0, 6, "VmHWM:") == 0)
+      return std::stoull(line.substr(6)) * 1024;
+  }
+  return 0;
+}
+
+/////////////////////////////////////////////////
+bool gazebo::benchmark::ResetPeakResidentSetSize()
+{
+  std::ofstream clearRefs("/proc/self/clear_refs");
+  clearRefs << "5";
+  clearRefs.close();
+  return !clearRefs.fail();
+}
+
+/////////////////////////////////////////////////
+void gazebo::benchmark::SetAllocationCounting(bool _enable)
+{
+  g_counting = _enable && kAllocationHook;
+}
+
+/////////////////////////////////////////////////
+bool gazebo::benchmark::AllocationCounting()
+{
+  return g_counting;
+}
+
+/////////////////////////////////////////////////
+uint64_t gazebo::benchmark::AllocationCount()
+{
+  return g_allocationCount;
+}
+
+/////////////////////////////////////////////////
+uint64_t gazebo::benchmark::AllocatedBytes()
+{
+  return g_allocatedBytes;
+}
+
+/////////////////////////////////////////////////
+void MemoryStats::Start()
+{
+  ResetPeakResidentSetSize();
+  this->startRss = ResidentSetSize();
+  this->counted = AllocationCounting();
+  this->startCount = AllocationCount();
+  this->startBytes = AllocatedBytes();
+}
+
+/////////////////////////////////////////////////
+void MemoryStats::Stop(uint64_t _steps)
+{
+  this->count = AllocationCount() - this->startCount;
+  this->bytes = AllocatedBytes() - this->startBytes;
+  this->counted = this->counted && AllocationCounting();
+  this->stopRss = ResidentSetSize();
+  this->peakRss = PeakResidentSetSize();
+  this->steps = _steps;
+}
+
+/////////////////////////////////////////////////
+double MemoryStats::PeakRss() const
+{
+  return static_cast<double>(this->peakRss);
+}
+
+/////////////////////////////////////////////////
+double MemoryStats::RssGrowth() const
+{
+  return static_cast<double>(this->stopRss) -
+         static_cast<double>(this->startRss);
+}
+
+/////////////////////////////////////////////////
+double MemoryStats::AllocationsPerStep() const
+{
+  if (!this->counted || this->steps == 0)
+    return -1.0;
+  return static_cast<double>(this->count) / this->steps;
+}
+
+/////////////////////////////////////////////////
+double MemoryStats::AllocatedBytesPerStep() const
+{
+  if (!this->counted || this->steps == 0)
+    return -1.0;
+  return static_cast<double>(this->bytes) / this->steps;
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_MEMORY_STATS_HH_
+#define BENCHMARK_GAZEBO_MEMORY_STATS_HH_
+
+#include <cstdint>
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Resident set size of the process.
+    /// \return Size in bytes, or 0 if unavailable.
+    uint64_t ResidentSetSize();
+
+    /// \brief Peak resident set size of the process since it started or
+    /// since the last ResetPeakResidentSetSize.
+    /// \return Size in bytes, or 0 if unavailable.
+    uint64_t PeakResidentSetSize();
+
+    /// \brief Reset the peak resident set size to the current size
+    /// (Linux 4.0 or later).
+    /// \return True if successful.
+    bool ResetPeakResidentSetSize();
+
+    /// \brief Enable or disable counting of heap allocations made through
+    /// malloc, calloc, realloc and the aligned variants by any thread.
+    /// Allocations are only counted with glibc, where these functions
+    /// are interposed by this library. Each counted allocation adds two
+    /// atomic increments on counters shared by all threads, so the step
+    /// times of runs with counting enabled are not comparable with runs
+    /// without it; enable it for allocation measurements only.
+    /// \param[in] _enable True to count allocations.
+    void SetAllocationCounting(bool _enable);
+
+    /// \brief True if heap allocations are being counted.
+    bool AllocationCounting();
+
+    /// \brief Number of heap allocations counted so far.
+    uint64_t AllocationCount();
+
+    /// \brief Number of bytes requested by the heap allocations
+    /// counted so far.
+    uint64_t AllocatedBytes();
+
+    /// \brief Memory use over an interval, such as a timed stepping loop:
+    /// resident set size growth, peak resident set size, and heap
+    /// allocations of all threads.
+    class MemoryStats
+    {
+      /// \brief Start the interval and reset the peak resident set size.
+      public: void Start();
+
+      /// \brief End the interval.
+      /// \param[in] _steps Number of steps in the interval, used to
+      /// compute allocations per step.
+      public: void Stop(uint64_t _steps);
+
+      /// \brief Peak resident set size during the interval in bytes
+      /// (since process start if it could not be reset).
+      public: double PeakRss() const;
+
+      /// \brief Growth of the resident set size over the interval in bytes.
+      public: double RssGrowth() const;
+
+      /// \brief Heap allocations per step, or -1 if not counted.
+      public: double AllocationsPerStep() const;
+
+      /// \brief Bytes allocated per step, or -1 if not counted.
+      public: double AllocatedBytesPerStep() const;
+
+      /// \brief Resident set size at the start.
+      private: uint64_t startRss = 0;
+
+      /// \brief Resident set size at the end.
+      private: uint64_t stopRss = 0;
+
+      /// \brief Peak resident set size at the end.
+      private: uint64_t peakRss = 0;
+
+      /// \brief Allocation count at the start.
+      private: uint64_t startCount = 0;
+
+      /// \brief Allocated bytes at the start.
+      private: uint64_t startBytes = 0;
+
+      /// \brief Allocations during the interval.
+      private: uint64_t count = 0;
+
+      /// \brief Bytes allocated during the interval.
+      private: uint64_t bytes = 0;
+
+      /// \brief Number of steps in the interval.
+      private: uint64_t steps = 0;
+
+      /// \brief True if allocations were counted during the interval.
+      private: bool counted = false;
+    };
+  }
+}
+#endif
@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "perf_counters.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+// Open one counter of a thread on any cpu, initially disabled.
+static int OpenCounter(int _tid, uint32_t _type, uint64_t _config)
+{
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = _type;
+  attr.config = _config;
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return syscall(__NR_perf_event_open, &attr, _tid, -1, -1, 0);
+}
+
+/////////////////////////////////////////////////
+PerfCounters::PerfCounters()
+{
+  this->fds.fill(-1);
+  this->values.fill(0.0);
+}
+
+/////////////////////////////////////////////////
+PerfCounters::~PerfCounters()
+{
+  this->Close();
+}
+
+/////////////////////////////////////////////////
+bool PerfCounters::Open(int _tid)
+{
+  this->Close();
+  this->fds[kInstructions] =
+      OpenCounter(_tid, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+  this->fds[kCycles] =
+      OpenCounter(_tid, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+  this->fds[kCacheMisses] =
+      OpenCounter(_tid, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+  this->fds[kBranchMisses] =
+      OpenCounter(_tid, PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+  this->fds[kContextSwitches] =
+      OpenCounter(_tid, PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES);
+
+  bool available = false;
+  for (const int fd : this->fds)
+    available = available || fd >= 0;
+  return available;
+}
+
+/////////////////////////////////////////////////
+void PerfCounters::Close()
+{
+  for (int &fd : this->fds)
+  {
+    if (fd >= 0)
+      close(fd);
+    fd = -1;
+  }
+}
+
+/////////////////////////////////////////////////
+void PerfCounters::Start()
+{
+  for (const int fd : this->fds)
+  {
+    if (fd < 0)
+      continue;
+    ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+  }
+}
+
+/////////////////////////////////////////////////
+void PerfCounters::Stop()
+{
+  for (int i = 0; i < kEventCount; ++i)
+  {
+    this->values[i] = 0.0;
+    if (this->fds[i] < 0)
+      continue;
+    ioctl(this->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+    // value, time enabled, time running
+    uint64_t data[3] = {0, 0, 0};
+    if (read(this->fds[i], data, sizeof(data)) != sizeof(data))
+      continue;
+    if (data[2] > 0)
+      this->values[i] = static_cast<double>(data[0]) * data[1] / data[2];
+  }
+}
+
+/////////////////////////////////////////////////
+bool PerfCounters::Available(Event _event) const
+{
+  return this->fds[_event] >= 0;
+}
+
+/////////////////////////////////////////////////
+double PerfCounters::Value(Event _event) const
+{
+  return this->values[_event];
+}
+
+/////////////////////////////////////////////////
+const char *PerfCounters::Name(Event _event)
+{
+  static const char *names[kEventCount] =
+  {
+    "instructions", "cycles", "cacheMisses", "branchMisses",
+    "contextSwitches"
+  };
+  return names[_event];
+}
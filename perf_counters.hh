@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_PERF_COUNTERS_HH_
+#define BENCHMARK_GAZEBO_PERF_COUNTERS_HH_
+
+#include <array>
+#include <cstdint>
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Hardware and software performance counters of one thread,
+    /// read through the Linux perf_event interface.
+    ///
+    /// Each counter is opened on its own, so that the available counters
+    /// still work when others are not supported, such as hardware
+    /// counters inside containers or virtual machines. Only user space
+    /// events are counted, which is allowed with perf_event_paranoid
+    /// up to 2.
+    class PerfCounters
+    {
+      /// \brief Counted events.
+      public: enum Event
+      {
+        /// \brief Retired instructions.
+        kInstructions = 0,
+
+        /// \brief CPU cycles.
+        kCycles,
+
+        /// \brief Last level cache misses.
+        kCacheMisses,
+
+        /// \brief Mispredicted branches.
+        kBranchMisses,
+
+        /// \brief Context switches.
+        kContextSwitches,
+
+        /// \brief Number of events.
+        kEventCount
+      };
+
+      /// \brief Constructor.
+      public: PerfCounters();
+
+      /// \brief Destructor, closes the counters.
+      public: ~PerfCounters();
+
+      /// \brief Open the counters of a thread.
+      /// \param[in] _tid Linux thread id, or 0 for the calling thread.
+      /// \return True if at least one counter is available.
+      public: bool Open(int _tid = 0);
+
+      /// \brief Close the counters.
+      public: void Close();
+
+      /// \brief Reset and enable the counters.
+      public: void Start();
+
+      /// \brief Disable the counters and read their values.
+      public: void Stop();
+
+      /// \brief True if an event is counted.
+      /// \param[in] _event Event.
+      public: bool Available(Event _event) const;
+
+      /// \brief Count of an event between Start and Stop, scaled up for
+      /// the time the counter was not scheduled when counters are
+      /// multiplexed.
+      /// \param[in] _event Event.
+      public: double Value(Event _event) const;
+
+      /// \brief Name of an event, such as instructions.
+      /// \param[in] _event Event.
+      public: static const char *Name(Event _event);
+
+      /// \brief File descriptor of each counter, -1 if unavailable.
+      private: std::array<int, kEventCount> fds;
+
+      /// \brief Values read by Stop.
+      private: std::array<double, kEventCount> values;
+
+      // Not copyable, since the file descriptors are owned.
+      private: PerfCounters(const PerfCounters &) = delete;
+      private: PerfCounters &operator=(const PerfCounters &) = delete;
+    };
+  }
+}
+#endif
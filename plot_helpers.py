@@ -4,7 +4,14 @@ import matplotlib.pyplot as plt
 mpl.rcParams.update({'font.size': 16})
 from csv_dictionary import *
 
-boxes = makeCsvDictOfArrays('test_results/BENCHMARK_boxes_dt.csv')
+# Results of BENCHMARK_boxes_dt, the default csvDict of the plots,
+# loaded on first use rather than at import
+_boxes = None
+def boxes():
+    global _boxes
+    if _boxes is None:
+        _boxes = makeCsvDictOfArrays('test_results/BENCHMARK_boxes_dt.csv')
+    return _boxes
 
 color1 = [0, 0, 0.5]
 color2 = [0.5, 0.5, 0.5]
@@ -36,7 +43,7 @@ def vector_log10_scale(x, scale):
 def plotEnginesDt(params, yname
                 , axscale=1.1
                 , ayscale=1.1
-                , csvDict=boxes
+                , csvDict=None
                 , legend='best'
                 , xname='dt'
                 , xlabel='Time step (s)'
@@ -54,12 +61,14 @@ def plotEnginesDt(params, yname
         engines['dart'] = ['$d$', 'g--']
     engines['ode'] = ['$O$', 'r--']
     engines['simbody'] = ['$S$', 'k--']
+    if csvDict is None:
+        csvDict = boxes()
     fig = plt.figure()
     xdata = {}
     ydata = {}
     for e in sorted(engines.keys()):
         params['engine'] = e
-        ii = np.array(list(query(csvDict, params)))
+        ii = query(csvDict, params)
         xdata[e] = csvDict[xname][ii]
         ydata[e] = csvDict[yname][ii]
         color = engines[e][1][0]
@@ -101,7 +110,7 @@ def plotEnginesDt(params, yname
         ydata_minmax[e] = [min(ydata[e]), max(ydata[e])]
 
 def plotEnginesTime(params, yname
-                  , csvDict=boxes
+                  , csvDict=None
                   , legend='best'
                   , skipDart=False
                   , xname='timeRatio'
@@ -127,7 +136,7 @@ def plotEnginesTime(params, yname
                   , title=title
                   )
 def plotEnginesModelCount(params, yname
-                  , csvDict=boxes
+                  , csvDict=None
                   , legend='best'
                   , skipDart=False
                   , xname='modelCount'
@@ -154,7 +163,7 @@ def plotEnginesModelCount(params, yname
                   )
 
 def plot3TimeDt(params
-                , csvDict=boxes
+                , csvDict=None
                 , yname='linPositionErr_maxAbs'
                 , title=''
                 , skipDart=False
@@ -188,7 +197,7 @@ def plot3TimeDt(params
                 )
 
 def plotErrorDt(classname, title_prefix
-                , csvDict=boxes
+                , csvDict=None
                 , legend='best'
                 , xscale='linear'
                 , yscale='linear'):
@@ -207,7 +216,7 @@ def plotErrorDt(classname, title_prefix
                   , csvDict=csvDict, legend=legend, yscale=yscale)
 
 def plotTimeDt(classname, title_prefix
-                , csvDict=boxes
+                , csvDict=None
                 , legend='best'
                 , yscale='linear'):
     p = {}
@@ -218,7 +227,7 @@ def plotTimeDt(classname, title_prefix
                   , csvDict=csvDict, legend=legend, yscale=yscale)
 
 def plotErrorTime(classname, title_prefix
-                  , csvDict=boxes
+                  , csvDict=None
                   , legend='best'
                   , yscale='linear'):
     p = {}
@@ -236,3 +245,31 @@ def plotErrorTime(classname, title_prefix
                     , csvDict=csvDict, legend=legend, yscale=yscale)
 
 
+
+# Plot step latency quantiles recorded by StepTimer against time step
+# or model count, one figure per quantile
+stepLatencyQuantiles = ['p50', 'p90', 'p99', 'p999', 'max']
+
+def plotStepLatencyDt(classname, title_prefix
+                      , csvDict=None
+                      , legend='best'
+                      , quantiles=stepLatencyQuantiles
+                      , yscale='log'):
+    p = {}
+    p['classname'] = classname
+    for q in quantiles:
+        plotEnginesDt(p, yname='stepLatency_' + q
+                      , title=title_prefix + 'step latency ' + q
+                      , ylabel='Step latency (s)'
+                      , csvDict=csvDict, legend=legend, yscale=yscale)
+
+def plotStepLatencyModelCount(params, title_prefix
+                              , csvDict=None
+                              , legend='best'
+                              , quantiles=stepLatencyQuantiles
+                              , yscale='log'):
+    for q in quantiles:
+        plotEnginesModelCount(params, yname='stepLatency_' + q
+                              , title=title_prefix + 'step latency ' + q
+                              , ylabel='Step latency (s)'
+                              , csvDict=csvDict, legend=legend, yscale=yscale)
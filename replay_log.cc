@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "gazebo/physics/physics.hh"
+#include "replay_log.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+// FNV-1a 64-bit constants
+static const uint64_t kFnvOffset = 14695981039346656037ULL;
+static const uint64_t kFnvPrime = 1099511628211ULL;
+
+namespace
+{
+  /// \brief Incremental FNV-1a hash of double values, which optionally
+  /// keeps the values as well.
+  class StateHash
+  {
+    /// \brief Constructor.
+    /// \param[in] _state Where to append the hashed values, or nullptr.
+    public: explicit StateHash(std::vector<double> *_state)
+      : state(_state)
+    {
+    }
+
+    /// \brief Hash a value by its bit pattern.
+    /// \param[in] _value Value.
+    public: void Add(double _value)
+    {
+      if (this->state)
+        this->state->push_back(_value);
+      // -0 and 0 compare equal and should hash the same
+      if (_value == 0)
+        _value = 0;
+      uint64_t bits;
+      std::memcpy(&bits, &_value, sizeof(bits));
+      for (int i = 0; i < 8; ++i)
+      {
+        this->hash ^= (bits >> (8 * i)) & 0xff;
+        this->hash *= kFnvPrime;
+      }
+    }
+
+    /// \brief Hash the components of a vector.
+    /// \param[in] _v Vector.
+    public: void Add(const ignition::math::Vector3d &_v)
+    {
+      this->Add(_v.X());
+      this->Add(_v.Y());
+      this->Add(_v.Z());
+    }
+
+    /// \brief Hash a position and orientation.
+    /// \param[in] _pose Pose.
+    public: void Add(const ignition::math::Pose3d &_pose)
+    {
+      this->Add(_pose.Pos());
+      this->Add(_pose.Rot().W());
+      this->Add(_pose.Rot().X());
+      this->Add(_pose.Rot().Y());
+      this->Add(_pose.Rot().Z());
+    }
+
+    /// \brief Stop appending values, for those only hashed.
+    public: void StopState()
+    {
+      this->state = nullptr;
+    }
+
+    /// \brief Current hash value.
+    public: uint64_t Value() const
+    {
+      return this->hash;
+    }
+
+    /// \brief Hashed values, or nullptr.
+    private: std::vector<double> *state;
+
+    /// \brief Current hash value.
+    private: uint64_t hash = kFnvOffset;
+  };
+}
+
+/////////////////////////////////////////////////
+ReplayLog::ReplayLog(double _tolerance)
+  : tolerance(_tolerance)
+{
+}
+
+/////////////////////////////////////////////////
+void ReplayLog::Add(uint64_t _step, physics::WorldPtr _world)
+{
+  Checkpoint checkpoint;
+  checkpoint.step = _step;
+  StateHash hash(this->tolerance > 0 ? &checkpoint.state : nullptr);
+  hash.Add(_world->SimTime().Double());
+  for (const auto &model : _world->Models())
+  {
+    for (const auto &link : model->GetLinks())
+    {
+      hash.Add(link->WorldPose());
+      hash.Add(link->WorldLinearVel());
+      hash.Add(link->WorldAngularVel());
+    }
+  }
+
+  // Contacts are only stored while someone uses them, and are only
+  // hashed since their order may change within the tolerance
+  hash.StopState();
+  physics::ContactManager *contactManager =
+      _world->Physics()->GetContactManager();
+  if (contactManager)
+  {
+    const unsigned int contactCount = contactManager->GetContactCount();
+    const auto &contacts = contactManager->GetContacts();
+    hash.Add(contactCount);
+    for (unsigned int i = 0; i < contactCount; ++i)
+    {
+      const physics::Contact *contact = contacts[i];
+      for (int j = 0; j < contact->count; ++j)
+      {
+        hash.Add(contact->positions[j]);
+        hash.Add(contact->normals[j]);
+        hash.Add(contact->depths[j]);
+      }
+    }
+  }
+  checkpoint.hash = hash.Value();
+  this->checkpoints.push_back(std::move(checkpoint));
+}
+
+/////////////////////////////////////////////////
+void ReplayLog::Clear()
+{
+  this->checkpoints.clear();
+}
+
+/////////////////////////////////////////////////
+size_t ReplayLog::Count() const
+{
+  return this->checkpoints.size();
+}
+
+/////////////////////////////////////////////////
+double ReplayLog::Tolerance() const
+{
+  return this->tolerance;
+}
+
+/////////////////////////////////////////////////
+bool ReplayLog::Write(const std::string &_filename) const
+{
+  std::ofstream out(_filename);
+  out << "# gazebo benchmark replay " << std::setprecision(17)
+      << this->tolerance << "\n";
+  for (const auto &checkpoint : this->checkpoints)
+  {
+    out << checkpoint.step << " " << std::hex << std::setw(16)
+        << std::setfill('0') << checkpoint.hash << std::dec;
+    for (const double value : checkpoint.state)
+      out << " " << value;
+    out << "\n";
+  }
+  return static_cast<bool>(out);
+}
+
+/////////////////////////////////////////////////
+bool ReplayLog::Read(const std::string &_filename)
+{
+  std::ifstream in(_filename);
+  std::string line;
+  if (!std::getline(in, line) ||
+      line.compare(0, 26, "# gazebo benchmark replay ") != 0)
+  {
+    return false;
+  }
+  this->tolerance = std::stod(line.substr(26));
+  this->checkpoints.clear();
+  while (std::getline(in, line))
+  {
+    std::istringstream fields(line);
+    Checkpoint checkpoint;
+    if (!(fields >> std::dec >> checkpoint.step >> std::hex
+                 >> checkpoint.hash >> std::dec))
+    {
+      return false;
+    }
+    // std::stod also reads the nan and inf of diverged states
+    std::string value;
+    while (fields >> value)
+    {
+      try
+      {
+        checkpoint.state.push_back(std::stod(value));
+      }
+      catch (const std::exception &)
+      {
+        return false;
+      }
+    }
+    this->checkpoints.push_back(std::move(checkpoint));
+  }
+  return in.eof();
+}
+
+/////////////////////////////////////////////////
+int64_t ReplayLog::FirstDivergence(const ReplayLog &_reference) const
+{
+  const auto &ours = this->checkpoints;
+  const auto &theirs = _reference.checkpoints;
+  const bool bounded = this->tolerance > 0;
+  const size_t count = std::min(ours.size(), theirs.size());
+  for (size_t i = 0; i < count; ++i)
+  {
+    bool same = ours[i].step == theirs[i].step;
+    if (same && bounded)
+    {
+      same = ours[i].state.size() == theirs[i].state.size();
+      for (size_t j = 0; same && j < ours[i].state.size(); ++j)
+      {
+        same = std::abs(ours[i].state[j] - theirs[i].state[j]) <=
+            this->tolerance;
+      }
+    }
+    else if (same)
+    {
+      same = ours[i].hash == theirs[i].hash;
+    }
+    if (!same)
+      return std::min(ours[i].step, theirs[i].step);
+  }
+  if (ours.size() > count)
+    return ours[count].step;
+  if (theirs.size() > count)
+    return theirs[count].step;
+  return -1;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_REPLAY_LOG_HH_
+#define BENCHMARK_GAZEBO_REPLAY_LOG_HH_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gazebo/physics/PhysicsTypes.hh"
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Compact log of the world state for deterministic replay:
+    /// a 64-bit hash of the simulation time, the pose and velocities of
+    /// every link and the stored contacts at checkpoint steps.
+    /// A reference log is written once, and later runs with other
+    /// settings compare their log against it to find the first step at
+    /// which the trajectories differ, without storing the trajectories.
+    ///
+    /// Hashes only match for bitwise identical states. For a bounded
+    /// comparison, a log with a tolerance also stores the time, poses and
+    /// velocities of each checkpoint, which grow with the number of links,
+    /// and checkpoints match when no value differs by more than the
+    /// tolerance; contacts are then not compared.
+    ///
+    /// File format, one checkpoint per line after a header line:
+    ///   # gazebo benchmark replay <tolerance>
+    ///   <step> <hash in hex> [<state values> with a tolerance]
+    class ReplayLog
+    {
+      /// \brief Constructor.
+      /// \param[in] _tolerance When greater than 0, store the state of
+      /// each checkpoint and compare states within this absolute
+      /// tolerance instead of comparing hashes.
+      public: explicit ReplayLog(double _tolerance = 0.0);
+
+      /// \brief Hash the state of a world and add it as a checkpoint.
+      /// \param[in] _step Number of steps since the start of the run.
+      /// \param[in] _world World to hash.
+      public: void Add(uint64_t _step, physics::WorldPtr _world);
+
+      /// \brief Remove all checkpoints.
+      public: void Clear();
+
+      /// \brief Number of checkpoints.
+      public: size_t Count() const;
+
+      /// \brief Tolerance of state comparisons, 0 to compare hashes.
+      public: double Tolerance() const;
+
+      /// \brief Write the checkpoints to a file.
+      /// \param[in] _filename Output file.
+      /// \return True if the file was written.
+      public: bool Write(const std::string &_filename) const;
+
+      /// \brief Replace the checkpoints and tolerance with those of a file.
+      /// \param[in] _filename Log written by Write.
+      /// \return True if the file was read.
+      public: bool Read(const std::string &_filename);
+
+      /// \brief Compare with a reference log of the same tolerance.
+      /// \param[in] _reference Reference log with the same checkpoints.
+      /// \return Step of the first checkpoint that differs, or of the
+      /// first checkpoint missing from either log, or -1 if the logs
+      /// match.
+      public: int64_t FirstDivergence(const ReplayLog &_reference) const;
+
+      /// \brief One checkpoint.
+      private: struct Checkpoint
+      {
+        /// \brief Number of steps since the start of the run.
+        uint64_t step;
+
+        /// \brief Hash of the state.
+        uint64_t hash;
+
+        /// \brief State values, only stored with a tolerance.
+        std::vector<double> state;
+      };
+
+      /// \brief Tolerance of state comparisons, 0 to compare hashes.
+      private: double tolerance = 0.0;
+
+      /// \brief Checkpoints in step order.
+      private: std::vector<Checkpoint> checkpoints;
+    };
+  }
+}
+#endif
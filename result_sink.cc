@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <set>
+
+#include "result_sink.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+// Append the bytes of a value to a buffer.
+template <typename T>
+static void Put(std::string &_buffer, const T &_value)
+{
+  _buffer.append(reinterpret_cast<const char *>(&_value), sizeof(T));
+}
+
+/////////////////////////////////////////////////
+bool ResultSink::Append(const std::string &_filename,
+                        const std::vector<ResultRow> &_rows)
+{
+  if (_filename.empty() || _rows.empty())
+    return false;
+
+  // Union of the columns, numeric unless a row holds a string
+  std::map<std::string, bool> columns;
+  for (const auto &row : _rows)
+  {
+    for (const auto &value : row)
+    {
+      auto column = columns.insert(std::make_pair(value.first, true)).first;
+      column->second = column->second && value.second.numeric;
+    }
+  }
+
+  std::string buffer;
+  Put(buffer, static_cast<uint32_t>(_rows.size()));
+  Put(buffer, static_cast<uint32_t>(columns.size()));
+  for (const auto &column : columns)
+  {
+    const std::string &name = column.first;
+    const bool numeric = column.second;
+    Put(buffer, static_cast<uint8_t>(numeric ? 0 : 1));
+    Put(buffer, static_cast<uint16_t>(name.size()));
+    buffer.append(name);
+    for (const auto &row : _rows)
+    {
+      auto value = row.find(name);
+      if (numeric)
+      {
+        Put(buffer, value == row.end() ?
+            std::numeric_limits<double>::quiet_NaN() : value->second.number);
+        continue;
+      }
+      std::string text;
+      if (value != row.end())
+      {
+        if (value->second.numeric)
+        {
+          char number[32];
+          snprintf(number, sizeof(number), "%.17g", value->second.number);
+          text = number;
+        }
+        else
+        {
+          text = value->second.text;
+        }
+      }
+      Put(buffer, static_cast<uint32_t>(text.size()));
+      buffer.append(text);
+    }
+  }
+
+  // Truncate each file once per process, then append whole batches
+  static std::mutex mutex;
+  static std::set<std::string> opened;
+  std::lock_guard<std::mutex> lock(mutex);
+  const bool first = opened.insert(_filename).second;
+  const int fd = open(_filename.c_str(),
+      O_WRONLY | O_CREAT | O_APPEND | (first ? O_TRUNC : 0), 0644);
+  if (fd < 0)
+  {
+    std::cerr << "Unable to open result file " << _filename << ": "
+              << strerror(errno) << std::endl;
+    return false;
+  }
+  if (first)
+    buffer.insert(0, "GZBRES01");
+
+  bool ok = true;
+  const char *data = buffer.data();
+  size_t size = buffer.size();
+  while (ok && size > 0)
+  {
+    const ssize_t n = write(fd, data, size);
+    ok = n > 0;
+    if (ok)
+    {
+      data += n;
+      size -= n;
+    }
+  }
+  ok = close(fd) == 0 && ok;
+  if (!ok)
+    std::cerr << "Unable to write result file " << _filename << std::endl;
+  return ok;
+}
+
+/////////////////////////////////////////////////
+ResultValue ResultSink::Parse(const std::string &_text)
+{
+  ResultValue value;
+  char *end = nullptr;
+  const double number = std::strtod(_text.c_str(), &end);
+  if (!_text.empty() && end == _text.c_str() + _text.size())
+  {
+    value.numeric = true;
+    value.number = number;
+  }
+  else
+  {
+    value.text = _text;
+  }
+  return value;
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef BENCHMARK_GAZEBO_RESULT_SINK_HH_
+#define BENCHMARK_GAZEBO_RESULT_SINK_HH_
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Value of one column in a row of results, either a number
+    /// stored at full precision or a string.
+    struct ResultValue
+    {
+      /// \brief True for a number.
+      bool numeric = false;
+
+      /// \brief Number, if numeric.
+      double number = 0.0;
+
+      /// \brief String, if not numeric.
+      std::string text;
+    };
+
+    /// \brief One row of results, by column name.
+    typedef std::map<std::string, ResultValue> ResultRow;
+
+    /// \brief Appends rows of results to a typed columnar binary file,
+    /// one batch of rows at a time.
+    ///
+    /// File layout (little endian):
+    ///   magic "GZBRES01"
+    ///   then batches until the end of the file:
+    ///     uint32 row count, uint32 column count
+    ///     for each column:
+    ///       uint8 type (0 float64, 1 string)
+    ///       uint16 name length, name bytes
+    ///       float64 values, or for each row uint32 length and bytes
+    ///
+    /// A column that is numeric in every row of a batch is stored as
+    /// float64, with NaN in rows without a value; other columns are
+    /// stored as strings. results.py loads the batches of one or more
+    /// files into numpy arrays.
+    class ResultSink
+    {
+      /// \brief Append a batch of rows to a file. The file is truncated
+      /// by the first append of the process, so a run replaces the
+      /// results of the previous run.
+      /// \param[in] _filename Output file.
+      /// \param[in] _rows Rows to append.
+      /// \return True if the batch was written.
+      public: static bool Append(const std::string &_filename,
+                                 const std::vector<ResultRow> &_rows);
+
+      /// \brief Parse a string as a number if it holds only a number.
+      /// \param[in] _text Value to parse.
+      /// \return Numeric value, or the string if it is not a number.
+      public: static ResultValue Parse(const std::string &_text);
+    };
+  }
+}
+#endif
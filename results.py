@@ -0,0 +1,108 @@
+import mmap
+import multiprocessing
+import struct
+import numpy as np
+
+from csv_dictionary import makeCsvDictOfArrays
+
+# Load result files written by ResultSink (the BENCHMARK_RESULTS_FILE of
+# each benchmark, or the files of each shard of a sweep).
+# Numeric columns are read directly into float64 arrays, with NaN where a
+# test did not record a value; other columns are arrays of strings.
+# Returns a dictionary of arrays with one entry per test case, like
+# makeCsvDictOfArrays in csv_dictionary.py.
+# Files are memory-mapped, so the numeric columns of a single file are
+# not copied.
+def loadResults(*filenames):
+    batches = []
+    for filename in filenames:
+        batches.extend(readResultBatches(filename))
+    return mergeResults(batches)
+
+# Read the (rowCount, columns) batches of one result file.
+def readResultBatches(filename):
+    batches = []
+    with open(filename, 'rb') as f:
+        try:
+            data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        except ValueError:
+            data = b''
+    if data[0:8] != b'GZBRES01':
+        raise ValueError('%s is not a result file' % filename)
+    offset = 8
+    while offset < len(data):
+        rowCount, columnCount = struct.unpack_from('<II', data, offset)
+        offset += 8
+        batch = {}
+        for _ in range(columnCount):
+            columnType, nameLength = struct.unpack_from('<BH', data, offset)
+            offset += 3
+            name = data[offset:offset + nameLength].decode()
+            offset += nameLength
+            if columnType == 0:
+                batch[name] = np.frombuffer(data, dtype='<f8',
+                                            count=rowCount, offset=offset)
+                offset += 8 * rowCount
+            else:
+                values = []
+                for _ in range(rowCount):
+                    length, = struct.unpack_from('<I', data, offset)
+                    offset += 4
+                    values.append(data[offset:offset + length].decode())
+                    offset += length
+                batch[name] = np.array(values, dtype=object)
+        batches.append((rowCount, batch))
+    return batches
+
+# Concatenate (rowCount, columns) batches into one dictionary of arrays,
+# with NaN or '' where a batch does not have a column.
+def mergeResults(batches):
+    # a column is numeric only if it is numeric in every batch
+    numeric = {}
+    for _, batch in batches:
+        for name, values in batch.items():
+            numeric[name] = numeric.get(name, True) and values.dtype != object
+    results = {}
+    for name in numeric:
+        parts = []
+        for rowCount, batch in batches:
+            values = batch.get(name)
+            if values is None:
+                values = np.full(rowCount, np.nan) if numeric[name] \
+                    else np.full(rowCount, '', dtype=object)
+            elif not numeric[name] and values.dtype != object:
+                values = np.array(['%.17g' % v for v in values], dtype=object)
+            parts.append(values)
+        if len(parts) == 1:
+            results[name] = parts[0]
+        else:
+            results[name] = np.concatenate(parts) if parts else np.array([])
+    return results
+
+def readBatches(filename):
+    if filename.endswith('.csv'):
+        csvDict = makeCsvDictOfArrays(filename)
+        csvDict.pop(None, None)
+        rowCount = len(next(iter(csvDict.values()))) if csvDict else 0
+        return [(rowCount, csvDict)]
+    return readResultBatches(filename)
+
+# Load any mix of result files and csv files written by junit_to_csv.rb
+# into one dictionary of arrays, reading the files in parallel worker
+# processes when there are several. processes defaults to the number of
+# cpus; with 1, files are read in this process.
+def loadFiles(filenames, processes=None):
+    filenames = list(filenames)
+    if processes is None:
+        processes = multiprocessing.cpu_count()
+    processes = min(processes, len(filenames))
+    if processes <= 1:
+        fileBatches = [readBatches(f) for f in filenames]
+    else:
+        pool = multiprocessing.Pool(processes)
+        try:
+            fileBatches = pool.map(readBatches, filenames)
+        finally:
+            pool.close()
+            pool.join()
+    return mergeResults([b for batches in fileBatches for b in batches])
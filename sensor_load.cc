@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <atomic>
+#include <cmath>
+#include <ctime>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "gazebo/physics/physics.hh"
+#include "gazebo/sensors/sensors.hh"
+#include "sensor_load.hh"
+#include "step_timer.hh"
+#include "world_builder.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+// Sdf of a sensor of a box link whose collision is named collision,
+// updated every 1ms.
+static std::string SensorSdf(const std::string &_type, int _index)
+{
+  std::ostringstream sdf;
+  sdf << "<sensor name='" << _type << "_" << _index
+      << "' type='" << _type << "'>\n"
+      << "  <always_on>1</always_on>\n"
+      << "  <update_rate>1000</update_rate>\n";
+  if (_type == "contact")
+  {
+    sdf << "  <contact><collision>collision</collision></contact>\n";
+  }
+  else if (_type == "ray")
+  {
+    // a planar scan over the neighboring boxes
+    sdf << "  <pose>0 0 0.2 0 0 0</pose>\n"
+        << "  <ray>\n"
+        << "    <scan><horizontal>\n"
+        << "      <samples>64</samples><resolution>1</resolution>\n"
+        << "      <min_angle>-3.14159</min_angle>"
+        << "<max_angle>3.14159</max_angle>\n"
+        << "    </horizontal></scan>\n"
+        << "    <range><min>0.05</min><max>10</max></range>\n"
+        << "  </ray>\n";
+  }
+  sdf << "</sensor>\n";
+  return sdf.str();
+}
+
+/////////////////////////////////////////////////
+// Sdf of a box of size _size resting on the ground at grid cell _index,
+// with the given sensors on its link.
+static std::string BoxSdf(const std::string &_name, int _index,
+                          double _size, const std::string &_sensors)
+{
+  std::ostringstream sdf;
+  sdf << "<model name='" << _name << "'>\n"
+      << "  <pose>" << 0.5 * (_index % 8) << " " << 0.5 * (_index / 8)
+      << " " << 0.5 * _size << " 0 0 0</pose>\n"
+      << "  <link name='link'>\n"
+      << "    <inertial><mass>1</mass><inertia>"
+      << "<ixx>0.00667</ixx><iyy>0.00667</iyy><izz>0.00667</izz>"
+      << "<ixy>0</ixy><ixz>0</ixz><iyz>0</iyz></inertia></inertial>\n"
+      << "    <collision name='collision'><geometry><box><size>"
+      << _size << " " << _size << " " << _size
+      << "</size></box></geometry></collision>\n"
+      << _sensors
+      << "  </link>\n"
+      << "</model>\n";
+  return sdf.str();
+}
+
+/////////////////////////////////////////////////
+// SensorLoad:
+// Time world steps without sensors, then with the boxes replaced by
+// boxes with sensors
+void SensorLoadFixture::SensorLoad(const std::string &_physicsEngine
+                                 , const std::string &_sensorType
+                                 , int _sensorCount
+                                 , bool _lockstep)
+{
+  ASSERT_GT(_sensorCount, 0);
+  ASSERT_TRUE(_sensorType == "contact" || _sensorType == "imu" ||
+              _sensorType == "ray") << _sensorType;
+
+  // 8 x 8 boxes resting on the ground, 0.5m apart, loaded without sensors
+  const int boxCount = 64;
+  const double size = 0.2;
+  std::vector<std::string> sensors(boxCount);
+  for (int i = 0; i < _sensorCount; ++i)
+    sensors[i % boxCount] += SensorSdf(_sensorType, i);
+
+  WorldBuilder builder;
+  builder.AddInclude("model://ground_plane");
+  std::ostringstream sdf;
+  for (int i = 0; i < boxCount; ++i)
+    sdf << BoxSdf("box_" + std::to_string(i), i, size, std::string());
+  builder.AddSdf(sdf.str(), boxCount);
+  const std::string worldFile = builder.WriteTemporary("sensor_load");
+  ASSERT_FALSE(worldFile.empty());
+  this->LoadArgs(std::string("-u ") + (_lockstep ? "--lockstep " : "") +
+      "-e " + _physicsEngine + " " + worldFile);
+  boost::filesystem::remove(worldFile);
+  physics::WorldPtr world = physics::get_world("default");
+  ASSERT_NE(world, nullptr);
+
+  // Verify physics engine type
+  physics::PhysicsEnginePtr physics = world->Physics();
+  ASSERT_NE(physics, nullptr);
+  ASSERT_EQ(physics->GetType(), _physicsEngine);
+  const double dt = 1e-3;
+  physics->SetMaxStepSize(dt);
+  physics->SetRealTimeUpdateRate(0.0);
+
+  const int steps = 2000;
+  auto timeSteps = [&](const std::string &_prefix)
+  {
+    StepTimer stepTimer;
+    const std::clock_t cpuStart = std::clock();
+    for (int i = 0; i < steps; ++i)
+    {
+      stepTimer.Start();
+      this->StepWorld(world, 1);
+      stepTimer.Stop();
+    }
+    // cpu time of all threads, including the sensor threads
+    const double cpuTime =
+        static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    this->Record(_prefix + "StepLatency_", stepTimer);
+    this->Record(_prefix + "StepWallTime", stepTimer.Total());
+    this->Record(_prefix + "CpuTimeRatio", cpuTime / (steps * dt));
+    return std::make_pair(stepTimer.Quantile(0.5), cpuTime);
+  };
+
+  // The baseline has no sensors at all, since deactivated sensors keep
+  // their contact manager filters and subscriptions.
+  // Let the boxes settle on the ground first.
+  this->StepWorld(world, 100);
+  const auto baseline = timeSteps("baseline");
+
+  // Replace each box with the same box with sensors, created by the
+  // sensor manager once the model is spawned.
+  for (int i = 0; i < boxCount; ++i)
+  {
+    world->RemoveModel("box_" + std::to_string(i));
+    const std::string name = "sensor_box_" + std::to_string(i);
+    this->SpawnSDF("<sdf version='1.6'>" +
+        BoxSdf(name, i, size, sensors[i]) + "</sdf>");
+    this->WaitUntilEntitySpawn(name, 100, 100);
+    ASSERT_NE(world->ModelByName(name), nullptr) << name;
+  }
+  sensors::SensorManager *manager = sensors::SensorManager::Instance();
+  for (int retry = 0; retry < 100 &&
+       (manager->GetSensors().size() < static_cast<size_t>(_sensorCount) ||
+        !manager->SensorsInitialized()); ++retry)
+  {
+    common::Time::MSleep(100);
+  }
+  sensors::Sensor_V allSensors = manager->GetSensors();
+  ASSERT_EQ(allSensors.size(), static_cast<size_t>(_sensorCount));
+
+  // Updates actually performed during the timed steps, lower than one per
+  // sensor and step without lockstep when the sensor threads fall behind
+  std::atomic<uint64_t> updates(0);
+  std::vector<event::ConnectionPtr> connections;
+  for (auto &sensor : allSensors)
+  {
+    connections.push_back(sensor->ConnectUpdated([&updates]()
+    {
+      updates.fetch_add(1, std::memory_order_relaxed);
+    }));
+  }
+  this->StepWorld(world, 100);
+  updates.store(0, std::memory_order_relaxed);
+  const auto active = timeSteps("sensor");
+  connections.clear();
+
+  this->Record("sensorStepOverhead", active.first - baseline.first);
+  this->Record("sensorStepOverheadPerSensor",
+      (active.first - baseline.first) / _sensorCount);
+  this->Record("sensorCpuTimePerSensor",
+      (active.second - baseline.second) / _sensorCount / (steps * dt));
+  this->Record("sensorUpdates", static_cast<double>(updates.load()));
+  this->Record("sensorUpdatesPerStep",
+      static_cast<double>(updates.load()) / _sensorCount / steps);
+}
+
+/////////////////////////////////////////////////
+TEST_P(SensorLoadTest, Sensors)
+{
+  std::string physicsEngine = std::tr1::get<0>(GetParam());
+  std::string sensorType    = std::tr1::get<1>(GetParam());
+  int sensorCount           = std::tr1::get<2>(GetParam());
+  bool lockstep             = std::tr1::get<3>(GetParam());
+  gzdbg << physicsEngine
+        << ", sensorType: " << sensorType
+        << ", sensorCount: " << sensorCount
+        << ", lockstep: " << lockstep
+        << std::endl;
+  RecordProperty("engine", physicsEngine);
+  RecordProperty("sensorType", sensorType);
+  this->Record("sensorCount", sensorCount);
+  RecordProperty("lockstep", lockstep);
+  SensorLoad(physicsEngine
+           , sensorType
+           , sensorCount
+           , lockstep);
+}
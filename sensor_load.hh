@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_SENSOR_LOAD_HH_
+#define BENCHMARK_GAZEBO_SENSOR_LOAD_HH_
+
+#include <string>
+#include "benchmark_fixture.hh"
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Fixture for the step cost of sensors attached to boxes
+    /// resting on a ground plane, so that contact sensors see contacts.
+    class SensorLoadFixture : public BenchmarkFixture
+    {
+      /// \brief Attach sensors of one type to a grid of 64 boxes, one per
+      /// box and then round robin, each updated at every step. The steps
+      /// are timed with boxes without sensors, then with each box replaced
+      /// by the same box with its sensors, and the median step time
+      /// overhead per sensor, the process cpu time per simulated second
+      /// and the number of sensor updates performed are recorded.
+      /// \param[in] _physicsEngine Physics engine to use.
+      /// \param[in] _sensorType Sensor type: contact, imu or ray.
+      /// \param[in] _sensorCount Number of sensors.
+      /// \param[in] _lockstep Update the sensors in lockstep with the
+      /// world (gzserver --lockstep), so that each step waits for the
+      /// sensors, instead of on the sensor threads alongside physics.
+      public: void SensorLoad(const std::string &_physicsEngine
+                            , const std::string &_sensorType
+                            , int _sensorCount
+                            , bool _lockstep);
+    };
+
+    // physics engine
+    // sensor type
+    // number of sensors
+    // lockstep on / off
+    typedef std::tr1::tuple < const char *
+                            , const char *
+                            , int
+                            , bool
+                            > char2int1bool1;
+    class SensorLoadTest : public SensorLoadFixture,
+        public testing::WithParamInterface<char2int1bool1>
+    {
+    };
+  }
+}
+#endif
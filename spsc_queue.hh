@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_SPSC_QUEUE_HH_
+#define BENCHMARK_GAZEBO_SPSC_QUEUE_HH_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Bounded lock-free queue for exactly one producer thread
+    /// and one consumer thread. All storage is allocated by the
+    /// constructor, so Push and Pop never allocate.
+    template <typename T>
+    class SpscQueue
+    {
+      /// \brief Constructor.
+      /// \param[in] _capacity Maximum number of queued items.
+      public: explicit SpscQueue(size_t _capacity)
+              : buffer(_capacity + 1)
+      {
+      }
+
+      /// \brief Add an item, called by the producer thread only.
+      /// \param[in] _item Item to copy into the queue.
+      /// \return False if the queue is full.
+      public: bool Push(const T &_item)
+      {
+        const size_t h = this->head.load(std::memory_order_relaxed);
+        const size_t next = this->Next(h);
+        if (next == this->tail.load(std::memory_order_acquire))
+          return false;
+        this->buffer[h] = _item;
+        this->head.store(next, std::memory_order_release);
+        return true;
+      }
+
+      /// \brief Remove the oldest item, called by the consumer thread only.
+      /// \param[out] _item Removed item.
+      /// \return False if the queue is empty.
+      public: bool Pop(T &_item)
+      {
+        const size_t t = this->tail.load(std::memory_order_relaxed);
+        if (t == this->head.load(std::memory_order_acquire))
+          return false;
+        _item = this->buffer[t];
+        this->tail.store(this->Next(t), std::memory_order_release);
+        return true;
+      }
+
+      /// \brief True if no items are queued.
+      public: bool Empty() const
+      {
+        return this->head.load(std::memory_order_acquire) ==
+               this->tail.load(std::memory_order_acquire);
+      }
+
+      /// \brief Index following _index in the ring.
+      private: size_t Next(size_t _index) const
+      {
+        return (_index + 1 == this->buffer.size()) ? 0 : _index + 1;
+      }
+
+      /// \brief Ring storage, one slot is always left empty.
+      private: std::vector<T> buffer;
+
+      /// \brief Next slot to write, owned by the producer.
+      private: std::atomic<size_t> head{0};
+
+      /// \brief Keep head and tail on separate cache lines.
+      private: char padding[64];
+
+      /// \brief Next slot to read, owned by the consumer.
+      private: std::atomic<size_t> tail{0};
+    };
+  }
+}
+#endif
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <regex>
+#include <set>
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <sdf/sdf.hh>
+
+#include "gazebo/common/CommonIface.hh"
+#include "gazebo/common/SystemPaths.hh"
+#include "gazebo/physics/physics.hh"
+#include "startup.hh"
+#include "step_timer.hh"
+#include "world_builder.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+typedef StepTimer::Clock clock;
+
+/////////////////////////////////////////////////
+// Seconds elapsed between two time points.
+static double Seconds(const clock::time_point &_start,
+                      const clock::time_point &_end)
+{
+  return std::chrono::duration<double>(_end - _start).count();
+}
+
+/////////////////////////////////////////////////
+// World load:
+// Load a world and record the time spent in each phase.
+void StartupFixture::LoadWorld(const std::string &_physicsEngine
+                             , const std::string &_world)
+{
+  std::string worldFile = _world;
+  const bool generated = _world.find("worlds/") != 0;
+  if (generated)
+  {
+    worldFile = WriteScene(_world);
+    ASSERT_FALSE(worldFile.empty());
+  }
+
+  // The world created event is signaled by the server thread at the end
+  // of World::Load, after the physics engine and models are loaded.
+  this->worldCreated = false;
+  event::ConnectionPtr createdConnection =
+      event::Events::ConnectWorldCreated([this](const std::string &)
+      {
+        this->worldCreatedTime = clock::now();
+        this->worldCreated = true;
+      });
+
+  const clock::time_point loadStart = clock::now();
+  this->Load(worldFile, true, _physicsEngine);
+  const clock::time_point loadEnd = clock::now();
+  createdConnection.reset();
+
+  physics::WorldPtr world = physics::get_world();
+  ASSERT_NE(world, nullptr);
+
+  // Verify physics engine type
+  physics::PhysicsEnginePtr physics = world->Physics();
+  ASSERT_NE(physics, nullptr);
+  ASSERT_EQ(physics->GetType(), _physicsEngine);
+
+  this->Record("loadTime", Seconds(loadStart, loadEnd));
+  EXPECT_TRUE(this->worldCreated);
+  if (this->worldCreated)
+  {
+    this->Record("worldCreateTime",
+        Seconds(loadStart, this->worldCreatedTime));
+    this->Record("loadReadyTime", Seconds(this->worldCreatedTime, loadEnd));
+  }
+  this->Record("modelCount", world->ModelCount());
+
+  // First step, which may allocate and initialize solver data,
+  // followed by steady state steps.
+  StepTimer firstStep;
+  firstStep.Start();
+  this->StepWorld(world, 1);
+  this->Record("firstStepTime", firstStep.Stop());
+  StepTimer stepTimer;
+  for (int i = 0; i < 100; ++i)
+  {
+    stepTimer.Start();
+    this->StepWorld(world, 1);
+    stepTimer.Stop();
+  }
+  this->Record("stepLatency_", stepTimer);
+
+  // Sdf parsing on its own, including expansion of <include> elements
+  const std::string worldPath = generated ? worldFile :
+      common::find_file(worldFile);
+  {
+    sdf::SDFPtr sdfParsed(new sdf::SDF());
+    sdf::init(sdfParsed);
+    const clock::time_point parseStart = clock::now();
+    EXPECT_TRUE(sdf::readFile(worldPath, sdfParsed));
+    this->Record("sdfParseTime", Seconds(parseStart, clock::now()));
+  }
+
+  // Resolution of each distinct model:// uri through GAZEBO_MODEL_PATH
+  {
+    std::ifstream in(worldPath);
+    const std::string text((std::istreambuf_iterator<char>(in)),
+                           std::istreambuf_iterator<char>());
+    const std::regex uriPattern("model://[^<\"' ]+");
+    std::set<std::string> uris(
+        std::sregex_token_iterator(text.begin(), text.end(), uriPattern),
+        std::sregex_token_iterator());
+    const clock::time_point resolveStart = clock::now();
+    for (const auto &uri : uris)
+    {
+      EXPECT_FALSE(common::SystemPaths::Instance()->FindFileURI(uri).empty())
+        << uri;
+    }
+    this->Record("modelPathTime", Seconds(resolveStart, clock::now()));
+    this->Record("modelUriCount", uris.size());
+  }
+
+  if (generated)
+    boost::filesystem::remove(worldFile);
+}
+
+/////////////////////////////////////////////////
+TEST_P(StartupTest, LoadWorld)
+{
+  std::string physicsEngine = std::tr1::get<0>(GetParam());
+  std::string worldName     = std::tr1::get<1>(GetParam());
+  gzdbg << physicsEngine
+        << ", world: " << worldName
+        << std::endl;
+  RecordProperty("engine", physicsEngine);
+  RecordProperty("world", worldName);
+  LoadWorld(physicsEngine
+          , worldName);
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_STARTUP_HH_
+#define BENCHMARK_GAZEBO_STARTUP_HH_
+
+#include <atomic>
+#include <string>
+#include "benchmark_fixture.hh"
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Fixture that measures the time to load a world
+    /// and take its first steps.
+    class StartupFixture : public BenchmarkFixture
+    {
+      /// \brief Time the phases of loading a world:
+      /// world creation (server start, sdf parsing, model path resolution,
+      /// engine initialization and model loading) up to the world created
+      /// event, the rest of ServerFixture::Load, the first step and later
+      /// steps. Sdf parsing and model path resolution are also timed on
+      /// their own after the load, with warm file caches.
+      /// \param[in] _physicsEngine Physics engine to use.
+      /// \param[in] _world World file, such as worlds/triball_drift.world,
+      /// or a generated scene named boxes_<count>, spheres_<pairs>
+      /// or triball_<N> (2N+1 triballs).
+      public: void LoadWorld(const std::string &_physicsEngine
+                           , const std::string &_world);
+
+      /// \brief Time at which the world created event was received.
+      private: StepTimer::Clock::time_point worldCreatedTime;
+
+      /// \brief True once worldCreatedTime is set.
+      private: std::atomic<bool> worldCreated;
+    };
+
+    // physics engine
+    // world file or generated scene
+    typedef std::tr1::tuple < const char *
+                            , const char *
+                            > char2;
+    class StartupTest : public StartupFixture,
+                        public testing::WithParamInterface<char2>
+    {
+    };
+  }
+}
+#endif
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_STEP_OBSERVER_HH_
+#define BENCHMARK_GAZEBO_STEP_OBSERVER_HH_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "spsc_queue.hh"
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Passes per-step state records from the stepping thread to a
+    /// worker thread that runs the analysis callback, so the analysis
+    /// overlaps with the next steps. Records are consumed in the order
+    /// they are published, so the results match running the callback
+    /// inline. Before Start or after Stop, Publish runs the callback
+    /// inline on the calling thread. An idle worker spins briefly and
+    /// then sleeps on a condition variable, so it does not keep a core
+    /// busy while the stepping thread runs.
+    template <typename T>
+    class StepObserver
+    {
+      /// \brief Analysis callback.
+      public: typedef std::function<void(const T &)> Callback;
+
+      /// \brief Constructor.
+      /// \param[in] _capacity Maximum number of queued records.
+      /// \param[in] _callback Analysis callback, called for every record.
+      public: StepObserver(size_t _capacity, const Callback &_callback)
+              : queue(_capacity), callback(_callback)
+      {
+      }
+
+      /// \brief Destructor, waits for queued records to be consumed.
+      public: ~StepObserver()
+      {
+        this->Stop();
+      }
+
+      /// \brief Start the worker thread.
+      public: void Start()
+      {
+        if (this->thread.joinable())
+          return;
+        this->done = false;
+        this->thread = std::thread(&StepObserver::Run, this);
+      }
+
+      /// \brief Publish a record, yielding while the queue is full.
+      /// Called by the stepping thread only.
+      /// \param[in] _record Record to copy into the queue.
+      public: void Publish(const T &_record)
+      {
+        if (!this->thread.joinable())
+        {
+          this->callback(_record);
+          return;
+        }
+        while (!this->queue.Push(_record))
+        {
+          ++this->stalls;
+          std::this_thread::yield();
+        }
+        this->Wake();
+      }
+
+      /// \brief Wait until every published record is consumed and stop
+      /// the worker thread. Results updated by the callback can be read
+      /// after this returns.
+      public: void Stop()
+      {
+        if (!this->thread.joinable())
+          return;
+        this->done = true;
+        this->Wake();
+        this->thread.join();
+      }
+
+      /// \brief Number of times Publish found the queue full.
+      public: uint64_t Stalls() const
+      {
+        return this->stalls;
+      }
+
+      /// \brief Wake the worker if it is sleeping.
+      private: void Wake()
+      {
+        // pairs with the fence in Sleep, so either the worker sees the
+        // new record or this sees that the worker sleeps
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (this->sleeping.load(std::memory_order_relaxed))
+        {
+          std::lock_guard<std::mutex> lock(this->mutex);
+          this->wake.notify_one();
+        }
+      }
+
+      /// \brief Sleep until a record is published or Stop is called.
+      private: void Sleep()
+      {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // the timeout only bounds the latency of an unexpected miss
+        this->wake.wait_for(lock, std::chrono::milliseconds(10), [this]
+        {
+          return !this->queue.Empty() || this->done;
+        });
+        this->sleeping.store(false, std::memory_order_relaxed);
+      }
+
+      /// \brief Worker thread loop.
+      private: void Run()
+      {
+        T record;
+        int idle = 0;
+        while (true)
+        {
+          // read done before draining the queue so no records pushed
+          // before Stop are left behind
+          const bool finished = this->done;
+          bool consumed = false;
+          while (this->queue.Pop(record))
+          {
+            this->callback(record);
+            consumed = true;
+          }
+          if (finished)
+            break;
+          if (consumed)
+            idle = 0;
+          else if (++idle < kSpinCount)
+            std::this_thread::yield();
+          else
+            this->Sleep();
+        }
+      }
+
+      /// \brief Empty polls of the worker before it sleeps.
+      private: static const int kSpinCount = 64;
+
+      /// \brief Queue of published records.
+      private: SpscQueue<T> queue;
+
+      /// \brief Analysis callback.
+      private: Callback callback;
+
+      /// \brief Worker thread.
+      private: std::thread thread;
+
+      /// \brief Set by Stop to end the worker thread.
+      private: std::atomic<bool> done{false};
+
+      /// \brief True while the worker sleeps or is about to.
+      private: std::atomic<bool> sleeping{false};
+
+      /// \brief Protects the sleep of the worker.
+      private: std::mutex mutex;
+
+      /// \brief Notified when a record is published or on Stop.
+      private: std::condition_variable wake;
+
+      /// \brief Number of times Publish found the queue full.
+      private: uint64_t stalls = 0;
+    };
+  }
+}
+#endif
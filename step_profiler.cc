@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+
+#include "gazebo/physics/physics.hh"
+#include "gazebo/transport/transport.hh"
+#include "step_profiler.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+// Nanoseconds of the steady clock.
+static int64_t SteadyNow()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/////////////////////////////////////////////////
+const char *StepProfiler::Name(Phase _phase)
+{
+  switch (_phase)
+  {
+    case kUpdate:
+      return "update";
+    case kPhysics:
+      return "physics";
+    default:
+      return "unknown";
+  }
+}
+
+/////////////////////////////////////////////////
+void StepProfiler::Connect()
+{
+  this->connections.push_back(event::Events::ConnectWorldUpdateBegin(
+      [this](const common::UpdateInfo &)
+      {
+        this->OnUpdateBegin();
+      }));
+  this->connections.push_back(event::Events::ConnectBeforePhysicsUpdate(
+      [this](const common::UpdateInfo &)
+      {
+        this->OnBeforePhysics();
+      }));
+  this->connections.push_back(event::Events::ConnectWorldUpdateEnd(
+      [this]()
+      {
+        this->OnUpdateEnd();
+      }));
+}
+
+/////////////////////////////////////////////////
+void StepProfiler::Disconnect()
+{
+  this->connections.clear();
+  this->subscriber.reset();
+  if (this->node)
+    this->node->Fini();
+  this->node.reset();
+}
+
+/////////////////////////////////////////////////
+void StepProfiler::SubscribeDiagnostics(physics::WorldPtr _world)
+{
+  if (this->node)
+    return;
+  this->node.reset(new transport::Node());
+  this->node->Init(_world->Name());
+  this->subscriber = this->node->Subscribe("~/diagnostics",
+      &StepProfiler::OnDiagnostics, this);
+}
+
+/////////////////////////////////////////////////
+void StepProfiler::Reset()
+{
+  for (auto &total : this->totals)
+    total.store(0, std::memory_order_relaxed);
+  this->steps.store(0, std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->diagnostics.clear();
+}
+
+/////////////////////////////////////////////////
+uint64_t StepProfiler::Steps() const
+{
+  return this->steps.load(std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////
+double StepProfiler::Total(Phase _phase) const
+{
+  return this->totals[_phase].load(std::memory_order_relaxed) * 1e-9;
+}
+
+/////////////////////////////////////////////////
+std::map<std::string, double> StepProfiler::DiagnosticTotals() const
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  return this->diagnostics;
+}
+
+/////////////////////////////////////////////////
+void StepProfiler::EnableTrace(size_t _steps)
+{
+  this->trace.assign(_steps * kPhaseCount, TraceEvent());
+  this->traceCount = 0;
+}
+
+/////////////////////////////////////////////////
+bool StepProfiler::WriteTrace(const std::string &_filename) const
+{
+  const size_t count = std::min(this->traceCount.load(), this->trace.size());
+  if (count == 0)
+    return false;
+  std::ofstream out(_filename);
+  out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+  for (size_t i = 0; i < count; ++i)
+  {
+    const TraceEvent &event = this->trace[i];
+    // timestamps and durations in microseconds
+    out << (i > 0 ? ",\n" : "")
+        << "{\"name\":\"" << Name(event.phase) << "\",\"ph\":\"X\""
+        << ",\"pid\":1,\"tid\":" << event.thread
+        << ",\"ts\":" << event.start * 1e-3
+        << ",\"dur\":" << event.duration * 1e-3 << "}";
+  }
+  out << "\n]}\n";
+  return static_cast<bool>(out);
+}
+
+/////////////////////////////////////////////////
+void StepProfiler::EndPhase(Phase _phase, int64_t _now)
+{
+  const int64_t duration = _now - this->phaseStart;
+  this->totals[_phase].fetch_add(duration, std::memory_order_relaxed);
+
+  const size_t index = this->traceCount.load(std::memory_order_relaxed);
+  if (index < this->trace.size())
+  {
+    static thread_local const int thread = syscall(SYS_gettid);
+    this->trace[index] = {_phase, thread, this->phaseStart, duration};
+    this->traceCount.store(index + 1, std::memory_order_relaxed);
+  }
+}
+
+/////////////////////////////////////////////////
+void StepProfiler::OnUpdateBegin()
+{
+  this->phaseStart = SteadyNow();
+}
+
+/////////////////////////////////////////////////
+void StepProfiler::OnBeforePhysics()
+{
+  const int64_t now = SteadyNow();
+  this->EndPhase(kUpdate, now);
+  this->phaseStart = now;
+}
+
+/////////////////////////////////////////////////
+void StepProfiler::OnUpdateEnd()
+{
+  this->EndPhase(kPhysics, SteadyNow());
+  this->steps.fetch_add(1, std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////
+void StepProfiler::OnDiagnostics(ConstDiagnosticsPtr &_msg)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  for (int i = 0; i < _msg->time_size(); ++i)
+  {
+    const auto &timer = _msg->time(i);
+    this->diagnostics[timer.name()] += msgs::Convert(timer.elapsed()).Double();
+  }
+}
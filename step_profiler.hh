@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_STEP_PROFILER_HH_
+#define BENCHMARK_GAZEBO_STEP_PROFILER_HH_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "gazebo/common/Events.hh"
+#include "gazebo/msgs/msgs.hh"
+#include "gazebo/physics/PhysicsTypes.hh"
+#include "gazebo/transport/TransportTypes.hh"
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Splits the time of each world update into phases using the
+    /// world update events, and accumulates the timers of the gazebo
+    /// diagnostics topic when gazebo is built with ENABLE_DIAGNOSTICS
+    /// (such as the collision and solver timers of ODEPhysics).
+    ///
+    /// Phases are timed on the thread that updates the world with two
+    /// clock reads per event, and added with relaxed fetch_add to atomic
+    /// totals shared with the test thread, which reads them. Without
+    /// ENABLE_DIAGNOSTICS only the update and physics phases are
+    /// available. The first steps can also be kept as chrome://tracing
+    /// events, in a buffer allocated by EnableTrace.
+    class StepProfiler
+    {
+      /// \brief Phases of a world update.
+      public: enum Phase
+      {
+        /// \brief World update begin to before physics update:
+        /// model and plugin updates.
+        kUpdate,
+
+        /// \brief Before physics update to world update end:
+        /// collision, constraints, solver and integration.
+        kPhysics,
+
+        /// \brief Number of phases.
+        kPhaseCount
+      };
+
+      /// \brief Name of a phase, such as physics.
+      /// \param[in] _phase Phase.
+      /// \return Phase name.
+      public: static const char *Name(Phase _phase);
+
+      /// \brief Connect to the world update events.
+      public: void Connect();
+
+      /// \brief Disconnect from the world update events and diagnostics.
+      public: void Disconnect();
+
+      /// \brief Subscribe to the diagnostics topic of a world, once.
+      /// \param[in] _world Loaded world.
+      public: void SubscribeDiagnostics(physics::WorldPtr _world);
+
+      /// \brief Clear the totals, keeping the trace.
+      public: void Reset();
+
+      /// \brief Number of world updates since the last Reset.
+      public: uint64_t Steps() const;
+
+      /// \brief Total time of a phase since the last Reset.
+      /// \param[in] _phase Phase.
+      /// \return Time in seconds.
+      public: double Total(Phase _phase) const;
+
+      /// \brief Total elapsed time of each diagnostics timer since the
+      /// last Reset, empty without diagnostics.
+      /// \return Seconds by timer name.
+      public: std::map<std::string, double> DiagnosticTotals() const;
+
+      /// \brief Keep the phases of the next world updates as trace events.
+      /// \param[in] _steps Number of world updates to keep.
+      public: void EnableTrace(size_t _steps);
+
+      /// \brief Write the trace events in the chrome://tracing JSON format.
+      /// \param[in] _filename Output file.
+      /// \return True if there were events and the file was written.
+      public: bool WriteTrace(const std::string &_filename) const;
+
+      /// \brief World update begin callback.
+      private: void OnUpdateBegin();
+
+      /// \brief Before physics update callback.
+      private: void OnBeforePhysics();
+
+      /// \brief World update end callback.
+      private: void OnUpdateEnd();
+
+      /// \brief Diagnostics topic callback.
+      /// \param[in] _msg Diagnostics of one world update.
+      private: void OnDiagnostics(ConstDiagnosticsPtr &_msg);
+
+      /// \brief End a phase that started at phaseStart.
+      /// \param[in] _phase Phase.
+      /// \param[in] _now Current time in nanoseconds.
+      private: void EndPhase(Phase _phase, int64_t _now);
+
+      /// \brief One trace event.
+      private: struct TraceEvent
+      {
+        /// \brief Phase.
+        Phase phase;
+
+        /// \brief Thread id of the updating thread.
+        int thread;
+
+        /// \brief Start time in nanoseconds.
+        int64_t start;
+
+        /// \brief Duration in nanoseconds.
+        int64_t duration;
+      };
+
+      /// \brief Start time of the current phase in nanoseconds.
+      private: int64_t phaseStart = 0;
+
+      /// \brief Total nanoseconds of each phase.
+      private: std::array<std::atomic<uint64_t>, kPhaseCount> totals{};
+
+      /// \brief Number of world updates.
+      private: std::atomic<uint64_t> steps{0};
+
+      /// \brief Trace events, allocated by EnableTrace.
+      private: std::vector<TraceEvent> trace;
+
+      /// \brief Number of used trace events.
+      private: std::atomic<size_t> traceCount{0};
+
+      /// \brief Protects diagnostics.
+      private: mutable std::mutex mutex;
+
+      /// \brief Diagnostics timer totals in seconds.
+      private: std::map<std::string, double> diagnostics;
+
+      /// \brief World event connections.
+      private: std::vector<event::ConnectionPtr> connections;
+
+      /// \brief Transport node of the diagnostics subscriber.
+      private: transport::NodePtr node;
+
+      /// \brief Diagnostics subscriber.
+      private: transport::SubscriberPtr subscriber;
+    };
+  }
+}
+#endif
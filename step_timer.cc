@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "step_timer.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+const int StepTimer::kSubBucketBits;
+const int StepTimer::kSubBucketCount;
+const int StepTimer::kBucketCount;
+
+/////////////////////////////////////////////////
+StepTimer::StepTimer()
+{
+  this->Reset();
+}
+
+/////////////////////////////////////////////////
+void StepTimer::Reset()
+{
+  this->buckets.fill(0);
+  this->count = 0;
+  this->sum = 0;
+  this->min = std::numeric_limits<uint64_t>::max();
+  this->max = 0;
+}
+
+/////////////////////////////////////////////////
+void StepTimer::Start()
+{
+  this->start = Clock::now();
+}
+
+/////////////////////////////////////////////////
+double StepTimer::Stop()
+{
+  const auto elapsed = Clock::now() - this->start;
+  const auto ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  this->Insert(ns > 0 ? static_cast<uint64_t>(ns) : 0u);
+  return std::chrono::duration<double>(elapsed).count();
+}
+
+/////////////////////////////////////////////////
+void StepTimer::Insert(uint64_t _ns)
+{
+  ++this->buckets[BucketIndex(_ns)];
+  ++this->count;
+  this->sum += _ns;
+  this->min = std::min(this->min, _ns);
+  this->max = std::max(this->max, _ns);
+}
+
+/////////////////////////////////////////////////
+uint64_t StepTimer::Count() const
+{
+  return this->count;
+}
+
+/////////////////////////////////////////////////
+double StepTimer::Total() const
+{
+  return this->sum * 1e-9;
+}
+
+/////////////////////////////////////////////////
+double StepTimer::Mean() const
+{
+  if (this->count == 0)
+    return 0.0;
+  return this->Total() / this->count;
+}
+
+/////////////////////////////////////////////////
+double StepTimer::Min() const
+{
+  if (this->count == 0)
+    return 0.0;
+  return this->min * 1e-9;
+}
+
+/////////////////////////////////////////////////
+double StepTimer::Max() const
+{
+  return this->max * 1e-9;
+}
+
+/////////////////////////////////////////////////
+double StepTimer::Quantile(double _q) const
+{
+  if (this->count == 0)
+    return 0.0;
+
+  // rank of the requested sample, counting from 1
+  const double q = std::min(std::max(_q, 0.0), 1.0);
+  const uint64_t rank = std::max<uint64_t>(1u,
+      static_cast<uint64_t>(std::ceil(q * this->count)));
+  if (rank >= this->count)
+    return this->Max();
+
+  uint64_t cumulative = 0;
+  for (int i = 0; i < kBucketCount; ++i)
+  {
+    cumulative += this->buckets[i];
+    if (cumulative >= rank)
+    {
+      // report the bucket midpoint, clamped to the observed range
+      const uint64_t lower = BucketLowerBound(i);
+      const uint64_t upper = (i + 1 < kBucketCount) ?
+          BucketLowerBound(i + 1) : this->max + 1;
+      const uint64_t mid = lower + (upper - lower - 1) / 2;
+      return std::min(std::max(mid, this->min), this->max) * 1e-9;
+    }
+  }
+  return this->Max();
+}
+
+/////////////////////////////////////////////////
+int StepTimer::BucketIndex(uint64_t _ns)
+{
+  // values below kSubBucketCount map one-to-one onto the first buckets
+  if (_ns < static_cast<uint64_t>(kSubBucketCount))
+    return static_cast<int>(_ns);
+
+  // otherwise use the top kSubBucketBits + 1 significant bits
+  const int msb = 63 - __builtin_clzll(_ns);
+  const int shift = msb - kSubBucketBits;
+  const int sub = static_cast<int>(_ns >> shift) - kSubBucketCount;
+  return kSubBucketCount * (shift + 1) + sub;
+}
+
+/////////////////////////////////////////////////
+uint64_t StepTimer::BucketLowerBound(int _index)
+{
+  if (_index < kSubBucketCount)
+    return static_cast<uint64_t>(_index);
+
+  const int shift = _index / kSubBucketCount - 1;
+  const uint64_t sub = _index % kSubBucketCount;
+  return (kSubBucketCount + sub) << shift;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_STEP_TIMER_HH_
+#define BENCHMARK_GAZEBO_STEP_TIMER_HH_
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Step latency recorder backed by a fixed-size log-linear
+    /// histogram of nanosecond durations. Each power of two is split into
+    /// 2^kSubBucketBits linear sub-buckets, so quantiles are accurate to
+    /// within 1 / 2^kSubBucketBits of the value. Inserting a sample never
+    /// allocates, so it is safe to call between physics steps.
+    class StepTimer
+    {
+      /// \brief Clock used to time steps.
+      public: typedef std::chrono::steady_clock Clock;
+
+      /// \brief Number of bits of linear resolution per power of two.
+      public: static const int kSubBucketBits = 6;
+
+      /// \brief Number of linear sub-buckets per power of two.
+      public: static const int kSubBucketCount = 1 << kSubBucketBits;
+
+      /// \brief Total number of histogram buckets.
+      public: static const int kBucketCount =
+                  kSubBucketCount * (64 - kSubBucketBits + 1);
+
+      /// \brief Constructor.
+      public: StepTimer();
+
+      /// \brief Clear all recorded samples.
+      public: void Reset();
+
+      /// \brief Start timing a step.
+      public: void Start();
+
+      /// \brief Stop timing the current step and record the sample.
+      /// \return Duration of the step in seconds.
+      public: double Stop();
+
+      /// \brief Record a duration.
+      /// \param[in] _ns Duration in nanoseconds.
+      public: void Insert(uint64_t _ns);
+
+      /// \brief Number of recorded samples.
+      public: uint64_t Count() const;
+
+      /// \brief Sum of all recorded samples in seconds.
+      public: double Total() const;
+
+      /// \brief Mean of recorded samples in seconds.
+      public: double Mean() const;
+
+      /// \brief Smallest recorded sample in seconds.
+      public: double Min() const;
+
+      /// \brief Largest recorded sample in seconds.
+      public: double Max() const;
+
+      /// \brief Estimate a quantile of the recorded samples.
+      /// \param[in] _q Quantile in [0, 1], for example 0.99.
+      /// \return Quantile value in seconds, 0 if there are no samples.
+      public: double Quantile(double _q) const;
+
+      /// \brief Histogram bucket index for a duration.
+      /// \param[in] _ns Duration in nanoseconds.
+      private: static int BucketIndex(uint64_t _ns);
+
+      /// \brief Smallest duration that maps to a bucket.
+      /// \param[in] _index Bucket index.
+      private: static uint64_t BucketLowerBound(int _index);
+
+      /// \brief Sample count per bucket.
+      private: std::array<uint64_t, kBucketCount> buckets;
+
+      /// \brief Number of samples.
+      private: uint64_t count;
+
+      /// \brief Sum of samples in nanoseconds.
+      private: uint64_t sum;
+
+      /// \brief Smallest sample in nanoseconds.
+      private: uint64_t min;
+
+      /// \brief Largest sample in nanoseconds.
+      private: uint64_t max;
+
+      /// \brief Start time of the current step.
+      private: Clock::time_point start;
+    };
+  }
+}
+#endif
@@ -0,0 +1,293 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <tuple>
+
+#include "memory_stats.hh"
+#include "telemetry.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+// Nanoseconds of the steady clock.
+static int64_t SteadyNow()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/////////////////////////////////////////////////
+// Quote a Prometheus label value.
+static std::string Quote(const std::string &_value)
+{
+  std::string quoted = "\"";
+  for (const char c : _value)
+  {
+    if (c == '\\' || c == '"')
+      quoted += std::string("\\") + c;
+    else if (c == '\n')
+      quoted += "\\n";
+    else
+      quoted += c;
+  }
+  return quoted + "\"";
+}
+
+/////////////////////////////////////////////////
+// Replace characters that are not valid in a Prometheus label name.
+static std::string LabelName(const std::string &_key)
+{
+  std::string name = _key;
+  for (char &c : name)
+  {
+    if (!std::isalnum(static_cast<unsigned char>(c)))
+      c = '_';
+  }
+  if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0])))
+    name = "_" + name;
+  return name;
+}
+
+/////////////////////////////////////////////////
+Telemetry::~Telemetry()
+{
+  this->Stop();
+}
+
+/////////////////////////////////////////////////
+bool Telemetry::Start(int _port, const std::string &_address)
+{
+  this->Stop();
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(_port);
+  if (inet_pton(AF_INET, _address.c_str(), &address.sin_addr) != 1)
+  {
+    std::cerr << "Invalid telemetry address [" << _address << "]"
+              << std::endl;
+    return false;
+  }
+
+  this->fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (this->fd < 0)
+    return false;
+  const int reuse = 1;
+  setsockopt(this->fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  if (bind(this->fd, reinterpret_cast<sockaddr *>(&address),
+           sizeof(address)) != 0 || listen(this->fd, 4) != 0)
+  {
+    std::cerr << "Unable to serve telemetry on " << _address << ":"
+              << _port << ": "
+              << std::strerror(errno) << std::endl;
+    close(this->fd);
+    this->fd = -1;
+    return false;
+  }
+
+  this->done = false;
+  this->thread = std::thread(&Telemetry::Serve, this);
+  return true;
+}
+
+/////////////////////////////////////////////////
+void Telemetry::Stop()
+{
+  this->done = true;
+  if (this->thread.joinable())
+    this->thread.join();
+  if (this->fd >= 0)
+  {
+    close(this->fd);
+    this->fd = -1;
+  }
+}
+
+/////////////////////////////////////////////////
+void Telemetry::SetInfo(const std::string &_key, const std::string &_value)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->info[_key] = _value;
+}
+
+/////////////////////////////////////////////////
+void Telemetry::SetValue(const std::string &_name, double _value)
+{
+  std::string name = _name;
+  std::string index;
+  const size_t dot = _name.rfind('.');
+  if (dot != std::string::npos && dot + 1 < _name.size() &&
+      std::all_of(_name.begin() + dot + 1, _name.end(),
+        [](unsigned char _c) { return std::isdigit(_c); }))
+  {
+    name = _name.substr(0, dot);
+    index = _name.substr(dot + 1);
+  }
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->values[std::make_pair(name, index)] = _value;
+}
+
+/////////////////////////////////////////////////
+std::atomic<double> &Telemetry::Gauge(const std::string &_name)
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  for (auto &gauge : this->gauges)
+  {
+    if (gauge.first == _name)
+      return gauge.second;
+  }
+  this->gauges.emplace_back(std::piecewise_construct,
+      std::forward_as_tuple(_name), std::forward_as_tuple(0.0));
+  return this->gauges.back().second;
+}
+
+/////////////////////////////////////////////////
+void Telemetry::AddSteps(uint64_t _steps, double _simTime)
+{
+  this->steps.fetch_add(_steps, std::memory_order_relaxed);
+  this->simTime.store(_simTime, std::memory_order_relaxed);
+  this->lastStepTime.store(SteadyNow(), std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////
+void Telemetry::Reset()
+{
+  std::lock_guard<std::mutex> lock(this->mutex);
+  this->info.clear();
+  this->values.clear();
+  for (auto &gauge : this->gauges)
+    gauge.second.store(0.0, std::memory_order_relaxed);
+}
+
+/////////////////////////////////////////////////
+std::string Telemetry::Render()
+{
+  const int64_t now = SteadyNow();
+  const uint64_t stepCount = this->steps.load(std::memory_order_relaxed);
+  const int64_t lastStep = this->lastStepTime.load(std::memory_order_relaxed);
+
+  // Steps per second since the previous scrape
+  double stepsPerSecond = 0.0;
+  if (this->scrapeTime > 0 && now > this->scrapeTime)
+  {
+    stepsPerSecond = (stepCount - this->scrapeSteps) /
+        ((now - this->scrapeTime) * 1e-9);
+  }
+  this->scrapeSteps = stepCount;
+  this->scrapeTime = now;
+
+  std::lock_guard<std::mutex> lock(this->mutex);
+  const auto test = this->info.find("test");
+  const std::string testLabel = "test=" +
+      Quote(test != this->info.end() ? test->second : std::string());
+
+  std::ostringstream out;
+  out.precision(17);
+  out << "# TYPE benchmark_info gauge\n"
+      << "benchmark_info{" << testLabel;
+  for (const auto &label : this->info)
+  {
+    if (label.first != "test")
+      out << "," << LabelName(label.first) << "=" << Quote(label.second);
+  }
+  out << "} 1\n";
+
+  out << "# TYPE benchmark_steps_total counter\n"
+      << "benchmark_steps_total{" << testLabel << "} " << stepCount << "\n"
+      << "# TYPE benchmark_steps_per_second gauge\n"
+      << "benchmark_steps_per_second{" << testLabel << "} "
+      << stepsPerSecond << "\n"
+      << "# TYPE benchmark_sim_time_seconds gauge\n"
+      << "benchmark_sim_time_seconds{" << testLabel << "} "
+      << this->simTime.load(std::memory_order_relaxed) << "\n"
+      << "# TYPE benchmark_seconds_since_step gauge\n"
+      << "benchmark_seconds_since_step{" << testLabel << "} "
+      << (lastStep > 0 ? (now - lastStep) * 1e-9 : -1.0) << "\n"
+      << "# TYPE benchmark_rss_bytes gauge\n"
+      << "benchmark_rss_bytes{" << testLabel << "} "
+      << ResidentSetSize() << "\n";
+
+  out << "# TYPE benchmark_live gauge\n";
+  for (const auto &gauge : this->gauges)
+  {
+    out << "benchmark_live{" << testLabel << ",name=" << Quote(gauge.first)
+        << "} " << gauge.second.load(std::memory_order_relaxed) << "\n";
+  }
+
+  out << "# TYPE benchmark_value gauge\n";
+  for (const auto &value : this->values)
+  {
+    out << "benchmark_value{" << testLabel
+        << ",name=" << Quote(value.first.first);
+    if (!value.first.second.empty())
+      out << ",case=" << Quote(value.first.second);
+    out << "} " << value.second << "\n";
+  }
+  return out.str();
+}
+
+/////////////////////////////////////////////////
+void Telemetry::Serve()
+{
+  while (!this->done)
+  {
+    pollfd listening = {this->fd, POLLIN, 0};
+    if (poll(&listening, 1, 100) <= 0)
+      continue;
+    const int client = accept4(this->fd, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client < 0)
+      continue;
+
+    // Any request gets the metrics, so only wait briefly for it
+    pollfd request = {client, POLLIN, 0};
+    if (poll(&request, 1, 1000) > 0)
+    {
+      char buffer[4096];
+      static_cast<void>(recv(client, buffer, sizeof(buffer), 0));
+    }
+    const std::string body = this->Render();
+    const std::string response =
+        "HTTP/1.0 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "\r\n" + body;
+    size_t sent = 0;
+    while (sent < response.size())
+    {
+      const ssize_t n = send(client, response.data() + sent,
+          response.size() - sent, MSG_NOSIGNAL);
+      if (n <= 0)
+        break;
+      sent += n;
+    }
+    close(client);
+  }
+}
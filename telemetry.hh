@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_TELEMETRY_HH_
+#define BENCHMARK_GAZEBO_TELEMETRY_HH_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Serves live progress of a running benchmark as Prometheus
+    /// text over HTTP, such as
+    ///
+    ///   benchmark_info{test="...",engine="ode"} 1
+    ///   benchmark_steps_total{test="..."} 12000
+    ///   benchmark_steps_per_second{test="..."} 5817.2
+    ///   benchmark_value{test="...",name="wallTime",case="3"} 2.1
+    ///
+    /// Steps and live gauges are atomics updated without locks, so they
+    /// can be updated from the stepping and analysis threads. Info labels
+    /// and recorded values take a mutex and are meant to be set between
+    /// cases. Metrics are formatted by the server thread when scraped,
+    /// which also samples the resident set size.
+    class Telemetry
+    {
+      /// \brief Destructor, stops the server.
+      public: ~Telemetry();
+
+      /// \brief Listen on a TCP port and start the server thread.
+      /// \param[in] _port Port.
+      /// \param[in] _address IPv4 address of the interface to listen on,
+      /// loopback by default so that the metrics are not served to other
+      /// hosts, or 0.0.0.0 for all interfaces.
+      /// \return True if the server is running.
+      public: bool Start(int _port,
+                         const std::string &_address = "127.0.0.1");
+
+      /// \brief Stop the server thread and close the port.
+      public: void Stop();
+
+      /// \brief Set a label of the benchmark_info metric, such as the
+      /// current test name or a test parameter.
+      /// \param[in] _key Label name.
+      /// \param[in] _value Label value.
+      public: void SetInfo(const std::string &_key, const std::string &_value);
+
+      /// \brief Set a recorded value, exposed as benchmark_value.
+      /// A numeric .<index> suffix is exposed as a case label.
+      /// \param[in] _name Value name, such as wallTime.3.
+      /// \param[in] _value Value.
+      public: void SetValue(const std::string &_name, double _value);
+
+      /// \brief Register a gauge exposed as benchmark_live, which can then
+      /// be set without locking. Registering the same name again returns
+      /// the same gauge.
+      /// \param[in] _name Gauge name, such as linPositionErrMaxAbs.
+      /// \return Gauge, valid until the Telemetry is destroyed.
+      public: std::atomic<double> &Gauge(const std::string &_name);
+
+      /// \brief Count finished steps.
+      /// \param[in] _steps Number of steps.
+      /// \param[in] _simTime Simulation time after the steps.
+      public: void AddSteps(uint64_t _steps, double _simTime);
+
+      /// \brief Clear the info labels, recorded values and gauge values,
+      /// at the start of a test. Step counts are kept.
+      public: void Reset();
+
+      /// \brief Format all metrics as Prometheus text.
+      /// \return Metrics text.
+      public: std::string Render();
+
+      /// \brief Server thread main loop.
+      private: void Serve();
+
+      /// \brief Listening socket, -1 when stopped.
+      private: int fd = -1;
+
+      /// \brief Set by Stop to end the server thread.
+      private: std::atomic<bool> done{false};
+
+      /// \brief Server thread.
+      private: std::thread thread;
+
+      /// \brief Protects info, values and gauges.
+      private: std::mutex mutex;
+
+      /// \brief Labels of benchmark_info.
+      private: std::map<std::string, std::string> info;
+
+      /// \brief Recorded values by name and case.
+      private: std::map<std::pair<std::string, std::string>, double> values;
+
+      /// \brief Live gauges by name, in a deque so that references stay
+      /// valid as gauges are added.
+      private: std::deque<std::pair<std::string, std::atomic<double>>> gauges;
+
+      /// \brief Total number of steps.
+      private: std::atomic<uint64_t> steps{0};
+
+      /// \brief Simulation time after the last step.
+      private: std::atomic<double> simTime{0.0};
+
+      /// \brief Steady clock time of the last step in nanoseconds.
+      private: std::atomic<int64_t> lastStepTime{0};
+
+      /// \brief Step count and steady clock time of the previous scrape,
+      /// used by the server thread for steps per second.
+      private: uint64_t scrapeSteps = 0;
+
+      /// \brief Steady clock time of the previous scrape in nanoseconds.
+      private: int64_t scrapeTime = 0;
+    };
+  }
+}
+#endif
@@ -1,3 +1,33 @@
+#################################################
+# Add a benchmark executable built from a test source and the extra
+# sources of gz_build_tests, linked against gtest and the gazebo test
+# fixture.
+macro (gz_add_benchmark_executable _name _source)
+  add_executable(${_name} ${_source} ${GZ_BUILD_TESTS_EXTRA_EXE_SRCS})
+
+  target_link_libraries(${_name}
+    gtest
+    gtest_main
+    gazebo_test_fixture
+    ${GAZEBO_LIBRARIES}
+    ${Boost_LIBRARIES}
+    ${CMAKE_DL_LIBS}
+  )
+endmacro()
+
+#################################################
+# Set the variable _var to the test environment of the benchmark
+# executable _name, followed by any extra VAR=value arguments.
+function (gz_benchmark_env _var _name)
+  set(_env_vars)
+  list(APPEND _env_vars "GAZEBO_MODEL_PATH=${CMAKE_SOURCE_DIR}/models:${GAZEBO_MODEL_PATH}")
+  list(APPEND _env_vars "BENCHMARK_RESULTS_FILE=${CMAKE_BINARY_DIR}/test_results/${_name}.results")
+  list(APPEND _env_vars "BENCHMARK_BACKEND_PATH=${CMAKE_BINARY_DIR}")
+  #list(APPEND _env_vars "GAZEBO_RESOURCE_PATH=${CMAKE_SOURCE_DIR}:${GAZEBO_RESOURCE_PATH}")
+  list(APPEND _env_vars ${ARGN})
+  set(${_var} "${_env_vars}" PARENT_SCOPE)
+endfunction()
+
 #################################################
 # Hack: extra sources to build binaries can be supplied to gz_build_tests in
 # the variable GZ_BUILD_TESTS_EXTRA_EXE_SRCS. This variable will be clean up
@@ -7,23 +37,12 @@ macro (gz_build_tests)
   foreach(GTEST_SOURCE_file ${ARGN})
     string(REGEX REPLACE ".cc" "" BINARY_NAME ${GTEST_SOURCE_file})
     set(BINARY_NAME ${TEST_TYPE}_${BINARY_NAME})
-    add_executable(${BINARY_NAME} ${GTEST_SOURCE_file}
-                   ${GZ_BUILD_TESTS_EXTRA_EXE_SRCS})
-
-    target_link_libraries(${BINARY_NAME}
-      gtest
-      gtest_main
-      gazebo_test_fixture
-      ${GAZEBO_LIBRARIES}
-      ${Boost_LIBRARIES}
-    )
+    gz_add_benchmark_executable(${BINARY_NAME} ${GTEST_SOURCE_file})
 
     add_test(${BINARY_NAME} ${CMAKE_CURRENT_BINARY_DIR}/${BINARY_NAME}
 	    --gtest_output=xml:${CMAKE_BINARY_DIR}/test_results/${BINARY_NAME}.xml)
 
-    set(_env_vars)
-    list(APPEND _env_vars "GAZEBO_MODEL_PATH=${CMAKE_SOURCE_DIR}/models:${GAZEBO_MODEL_PATH}")
-    #list(APPEND _env_vars "GAZEBO_RESOURCE_PATH=${CMAKE_SOURCE_DIR}:${GAZEBO_RESOURCE_PATH}")
+    gz_benchmark_env(_env_vars ${BINARY_NAME})
     set_tests_properties(${BINARY_NAME} PROPERTIES
       TIMEOUT 240
       ENVIRONMENT "${_env_vars}"
@@ -42,9 +61,46 @@ macro (gz_build_tests)
       ${CMAKE_CURRENT_SOURCE_DIR}/test_results/${BINARY_NAME}
     )
 
+    # Run the test cases as parallel shards with `make sweep_<binary>`
+    # and merge the results into the same csv as the csv_ test above.
+    add_custom_target(sweep_${BINARY_NAME}
+      COMMAND python3 ${PROJECT_SOURCE_DIR}/tools/sweep_runner.py
+        ${CMAKE_CURRENT_BINARY_DIR}/${BINARY_NAME}
+        ${CMAKE_CURRENT_SOURCE_DIR}/test_results/${BINARY_NAME}
+        --output-dir ${CMAKE_BINARY_DIR}/test_results
+      DEPENDS ${BINARY_NAME}
+    )
+
     install(TARGETS ${BINARY_NAME}
       RUNTIME DESTINATION bin
     )
+
+    # Same test built with BENCHMARK_PROFILE, which records the time of
+    # each world update phase and can write chrome://tracing files.
+    if (BENCHMARK_PROFILE_VARIANTS)
+      set(PROFILE_BINARY_NAME ${BINARY_NAME}_profile)
+      gz_add_benchmark_executable(${PROFILE_BINARY_NAME} ${GTEST_SOURCE_file})
+      set_property(TARGET ${PROFILE_BINARY_NAME}
+        APPEND PROPERTY COMPILE_DEFINITIONS BENCHMARK_PROFILE)
+
+      add_test(${PROFILE_BINARY_NAME}
+        ${CMAKE_CURRENT_BINARY_DIR}/${PROFILE_BINARY_NAME}
+        --gtest_output=xml:${CMAKE_BINARY_DIR}/test_results/${PROFILE_BINARY_NAME}.xml)
+      gz_benchmark_env(_profile_env_vars ${PROFILE_BINARY_NAME}
+        "BENCHMARK_TRACE_DIR=${CMAKE_BINARY_DIR}/test_results")
+      # the longest timeout of any benchmark, since the per-test timeouts
+      # are only set for the regular executables
+      set_tests_properties(${PROFILE_BINARY_NAME} PROPERTIES
+        TIMEOUT 20000
+        ENVIRONMENT "${_profile_env_vars}"
+      )
+      add_test(NAME csv_${PROFILE_BINARY_NAME}
+        COMMAND
+        ${PROJECT_SOURCE_DIR}/tools/junit_to_csv.rb
+        ${CMAKE_BINARY_DIR}/test_results/${PROFILE_BINARY_NAME}.xml
+        ${CMAKE_CURRENT_SOURCE_DIR}/test_results/${PROFILE_BINARY_NAME}
+      )
+    endif()
   endforeach()
 
   set(GZ_BUILD_TESTS_EXTRA_EXE_SRCS "")
@@ -0,0 +1,211 @@
+#!/usr/bin/env python3
+"""
+Compares a benchmark csv against a baseline csv, such as the committed
+test_results/BENCHMARK_boxes_dt.csv, and exits with a non-zero code if
+any metric regressed.
+
+Rows are joined on the test parameters. A metric regresses when its new
+value exceeds the baseline by more than the threshold. When both rows were
+recorded with several trials (trials column, with <metric>_mean and
+<metric>_stddev columns), the slowdown must also be significant according
+to a one-sided Welch t-test, with the number of trials actually run
+(trialsRun, or trials for older files).
+
+Rows must be unique on the key columns; add --key columns, such as iters
+and sor for solver sweeps, when they are not. Baseline rows missing from
+the new run, or a run without any comparison, also fail unless
+--allow-missing is given.
+
+With --report, the ratios are printed as a report, such as the gzserver
+overhead of BENCHMARK_boxes_dt over BENCHMARK_boxes_headless, without
+checking for regressions.
+"""
+
+from __future__ import print_function
+NAME = "compare_results.py"
+
+import argparse
+import csv
+import math
+import sys
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(prog=NAME, description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('baseline', help='baseline csv file')
+    parser.add_argument('current', help='csv file of the new run')
+    parser.add_argument('--key', action='append',
+        help='column to join rows on, may be repeated (default: engine, '
+             'dt, modelCount, collision, isComplex)')
+    parser.add_argument('--metric', action='append',
+        help='column where larger is worse, may be repeated '
+             '(default: wallTime and timeRatio)')
+    parser.add_argument('--threshold', type=float, default=0.1,
+        help='relative slowdown tolerated, 0.1 for 10%% (default: 0.1)')
+    parser.add_argument('--alpha', type=float, default=0.05,
+        help='significance level of the t-test (default: 0.05)')
+    parser.add_argument('--report', action='store_true',
+        help='print the ratio of every comparison and the geometric mean '
+             'of each metric, such as the server / headless overhead, '
+             'instead of checking for regressions; always exits 0 unless '
+             'rows are duplicated')
+    parser.add_argument('--allow-missing', action='store_true',
+        help='do not fail when baseline rows are missing from the new run '
+             'or nothing was compared')
+    parser.add_argument('-v', '--verbose', action='store_true',
+        help='print every comparison, not only the regressions')
+    args = parser.parse_args()
+    args.key = args.key or ['engine', 'dt', 'modelCount', 'collision',
+                            'isComplex']
+    args.metric = args.metric or ['wallTime', 'timeRatio']
+    return args
+
+
+def number(text):
+    try:
+        return float(text)
+    except (TypeError, ValueError):
+        return None
+
+
+def normalize(text):
+    """Key value that matches regardless of number formatting."""
+    x = number(text)
+    return text if x is None else '%g' % x
+
+
+def load(filename, keys):
+    with open(filename, 'rt') as csvfile:
+        rows = {}
+        for row in csv.DictReader(csvfile):
+            key = tuple(normalize(row.get(k, '')) for k in keys)
+            if key in rows:
+                raise SystemExit('%s: %s has several rows with %s, '
+                                 'add --key columns to tell them apart'
+                                 % (NAME, filename, ' '.join(
+                                     '%s=%s' % kv for kv in zip(keys, key))))
+            rows[key] = row
+        return rows
+
+
+def trial_count(row):
+    """Number of trials run, fewer than requested after an early stop."""
+    n = number(row.get('trialsRun'))
+    return n if n is not None else number(row.get('trials'))
+
+
+def betacf(a, b, x):
+    """Continued fraction of the incomplete beta function (Lentz)."""
+    tiny = 1e-300
+    c, d = 1.0, 1.0 - (a + b) * x / (a + 1.0)
+    d = 1.0 / (d if abs(d) > tiny else tiny)
+    h = d
+    for m in range(1, 300):
+        for numerator in (m * (b - m) * x / ((a + 2*m - 1) * (a + 2*m)),
+                          -(a + m) * (a + b + m) * x
+                          / ((a + 2*m) * (a + 2*m + 1))):
+            d = 1.0 + numerator * d
+            d = 1.0 / (d if abs(d) > tiny else tiny)
+            c = 1.0 + numerator / c
+            c = c if abs(c) > tiny else tiny
+            h *= d * c
+        if abs(d * c - 1.0) < 1e-12:
+            break
+    return h
+
+
+def betainc(a, b, x):
+    """Regularized incomplete beta function I_x(a, b)."""
+    if x <= 0.0:
+        return 0.0
+    if x >= 1.0:
+        return 1.0
+    front = math.exp(math.lgamma(a + b) - math.lgamma(a) - math.lgamma(b)
+                     + a * math.log(x) + b * math.log(1.0 - x))
+    if x < (a + 1.0) / (a + b + 2.0):
+        return front * betacf(a, b, x) / a
+    return 1.0 - front * betacf(b, a, 1.0 - x) / b
+
+
+def welch_p_value(mean0, sd0, n0, mean1, sd1, n1):
+    """One-sided p-value of mean1 > mean0 from summary statistics."""
+    v0, v1 = sd0 * sd0 / n0, sd1 * sd1 / n1
+    if v0 + v1 <= 0.0:
+        return 0.0 if mean1 > mean0 else 1.0
+    t = (mean1 - mean0) / math.sqrt(v0 + v1)
+    dof = (v0 + v1) ** 2 / (v0 * v0 / (n0 - 1) + v1 * v1 / (n1 - 1))
+    tail = 0.5 * betainc(dof / 2.0, 0.5, dof / (dof + t * t))
+    return tail if t > 0 else 1.0 - tail
+
+
+def compare(args, base, new, metric):
+    """Return (ratio, p-value or None, regressed) or None if missing."""
+    b, c = number(base.get(metric)), number(new.get(metric))
+    if b is None or c is None or b <= 0.0:
+        return None
+    ratio = c / b
+    p = None
+    n0, n1 = trial_count(base), trial_count(new)
+    sd0 = number(base.get(metric + '_stddev'))
+    sd1 = number(new.get(metric + '_stddev'))
+    mean0 = number(base.get(metric + '_mean'))
+    mean1 = number(new.get(metric + '_mean'))
+    if None not in (n0, n1, sd0, sd1, mean0, mean1) and n0 > 1 and n1 > 1:
+        p = welch_p_value(mean0, sd0, n0, mean1, sd1, n1)
+    regressed = ratio > 1.0 + args.threshold and (p is None or p < args.alpha)
+    return ratio, p, regressed
+
+
+def main():
+    args = parse_args()
+    baseline = load(args.baseline, args.key)
+    current = load(args.current, args.key)
+
+    regressions, compared = 0, 0
+    logRatios = dict((m, []) for m in args.metric)
+    missing = [k for k in baseline if k not in current]
+    for key in sorted(k for k in current if k in baseline):
+        for metric in args.metric:
+            result = compare(args, baseline[key], current[key], metric)
+            if result is None:
+                continue
+            compared += 1
+            ratio, p, regressed = result
+            if args.report:
+                if ratio > 0.0:
+                    logRatios[metric].append(math.log(ratio))
+                print('%s %s: %.3fx' % (
+                    ' '.join('%s=%s' % kv for kv in zip(args.key, key)),
+                    metric, ratio))
+                continue
+            regressions += regressed
+            if regressed or args.verbose:
+                print('%s %s %s: %.3fx%s' % (
+                    'REGRESSION' if regressed else 'ok',
+                    ' '.join('%s=%s' % kv for kv in zip(args.key, key)),
+                    metric, ratio, '' if p is None else ' (p=%.3g)' % p))
+
+    for key in missing:
+        print('missing: %s' % ' '.join('%s=%s' % kv
+                                      for kv in zip(args.key, key)),
+              file=sys.stderr)
+    if args.report:
+        for metric in args.metric:
+            logs = logRatios[metric]
+            if logs:
+                print('%s: geometric mean %.3fx over %d rows' % (
+                    metric, math.exp(sum(logs) / len(logs)), len(logs)))
+        return 0
+    print('%d regressions in %d comparisons, %d baseline rows missing'
+          % (regressions, compared, len(missing)))
+    if not args.allow_missing and (missing or not compared):
+        print('%s: failing on %s, use --allow-missing to ignore'
+              % (NAME, 'missing rows' if missing else 'no comparisons'),
+              file=sys.stderr)
+        return 1
+    return 1 if regressions else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
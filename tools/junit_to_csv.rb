@@ -1,18 +1,55 @@
 #!/usr/bin/env ruby
 
+# Usage: junit_to_csv.rb input.xml [input2.xml ...] output_prefix
+# Multiple junit files (such as the shards written by sweep_runner.py)
+# are merged into a single csv.
+
 require 'rexml/document'
 
-xmlInput = File.read(ARGV[0])
-csvOutputPrefix = ARGV[1]
+xmlInputs = ARGV[0..-2]
+csvOutputPrefix = ARGV[-1]
+
+timestamp, arrayOfHashes, suiteOrder = nil, [], []
+xmlInputs.each do |xmlInput|
+  doc = REXML::Document.new(File.read(xmlInput))
+  timestamp ||= doc.elements.first.attributes["timestamp"]
+  # check_test_ran.py writes a root testsuite for crashed tests
+  doc.elements.each('testsuites/testsuite/testcase | testsuite/testcase') do |t|
+    suiteOrder << t.attributes["classname"] unless
+      suiteOrder.include?(t.attributes["classname"])
+    attributes = {}
+    t.attributes.each { |k, v| attributes[k] = v }
+    arrayOfHashes << attributes
+  end
+end
+
+# Tests that record several cases (name.index attributes, see
+# BenchmarkFixture::SetRecordCase) are expanded into one row per case,
+# sharing the attributes recorded without an index.
+arrayOfHashes = arrayOfHashes.flat_map do |h|
+  cases = h.keys.map { |k| k[/\.(\d+)\z/, 1] }.compact.uniq.sort_by(&:to_i)
+  next [h] if cases.empty?
+  shared = h.reject { |k, _| k =~ /\.\d+\z/ }
+  cases.map do |c|
+    row = shared.merge("name" => shared["name"] + "." + c)
+    h.each { |k, v| row[k.chomp("." + c)] = v if k.end_with?("." + c) }
+    row
+  end
+end
 
-doc, arrayOfHashes = REXML::Document.new(xmlInput), []
-doc.elements.each('testsuites/testsuite/testcase') do |t|
-  arrayOfHashes << t.attributes
+# Restore the order of a serial run when merging shards:
+# by test suite, then by the index of each parameterized test.
+if xmlInputs.size > 1
+  arrayOfHashes = arrayOfHashes.each_with_index.sort_by do |h, i|
+    [suiteOrder.index(h["classname"]), h["name"].split('/').last.to_i, i]
+  end.map(&:first)
 end
-sortedKeys = arrayOfHashes.first.keys.sort
+
+sortedKeys = arrayOfHashes.map { |h| h.keys }.flatten.uniq.sort
 sortedKeys.delete("value_param")
 
-timestamp = doc.elements.first.attributes["timestamp"]
+# failure files of crashed tests have no timestamp
+timestamp ||= Time.now.strftime("%Y-%m-%dT%H:%M:%S")
 csvOutput = csvOutputPrefix + "_" + timestamp + ".csv"
 File.open(csvOutput, "w") do |f|
   f.puts sortedKeys.join(',')
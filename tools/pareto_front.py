@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+"""
+Prints the Pareto front of cost against accuracy from a benchmark csv,
+such as the one written for BENCHMARK_boxes_solver.
+
+A row is on the front if no other row of the same group (by default the
+same engine) is at least as good in the cost column and every error
+column, and strictly better in one of them. The rows of each group are
+printed from the cheapest to the most expensive.
+"""
+
+from __future__ import print_function
+NAME = "pareto_front.py"
+
+import argparse
+import csv
+import math
+import sys
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(prog=NAME, description=__doc__,
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('csv', help='csv file written by junit_to_csv.rb')
+    parser.add_argument('--cost', default='timeRatio',
+        help='cost column to minimize (default: timeRatio)')
+    parser.add_argument('--error', action='append',
+        help='error column to minimize, may be repeated '
+             '(default: refPositionErr_max and energyError_maxAbs)')
+    parser.add_argument('--group', action='append',
+        help='column to group rows by, may be repeated (default: engine)')
+    parser.add_argument('--show', action='append',
+        help='extra column to print, may be repeated '
+             '(default: dt, iters and sor)')
+    args = parser.parse_args()
+    args.error = args.error or ['refPositionErr_max', 'energyError_maxAbs']
+    args.group = args.group or ['engine']
+    args.show = args.show or ['dt', 'iters', 'sor']
+    return args
+
+
+def value(row, column):
+    """Absolute value of a numeric column, None if missing or NaN."""
+    try:
+        v = abs(float(row[column]))
+    except (KeyError, TypeError, ValueError):
+        return None
+    return None if math.isnan(v) else v
+
+
+def dominates(a, b):
+    """True if objective tuple a dominates b."""
+    return all(x <= y for x, y in zip(a, b)) and \
+        any(x < y for x, y in zip(a, b))
+
+
+def main():
+    args = parse_args()
+    with open(args.csv, 'rt') as csvfile:
+        rows = list(csv.DictReader(csvfile))
+
+    columns = [args.cost] + args.error
+    groups = {}
+    for row in rows:
+        objectives = tuple(value(row, c) for c in columns)
+        if None in objectives:
+            continue
+        key = tuple(row.get(g, '') for g in args.group)
+        groups.setdefault(key, []).append((objectives, row))
+    if not groups:
+        print("No rows with columns %s" % ', '.join(columns), file=sys.stderr)
+        return 1
+
+    header = args.group + args.show + columns
+    print(','.join(header))
+    for key in sorted(groups):
+        candidates = groups[key]
+        front = [(o, r) for o, r in candidates
+                 if not any(dominates(other, o) for other, _ in candidates)]
+        for objectives, row in sorted(front, key=lambda c: c[0]):
+            print(','.join(list(key) + [row.get(c, '') for c in args.show]
+                           + ['%g' % o for o in objectives]))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
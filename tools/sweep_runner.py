@@ -0,0 +1,145 @@
+#!/usr/bin/env python3
+"""
+Runs a gtest benchmark binary as several sharded worker processes.
+
+Each worker runs a disjoint subset of the parameterized test cases using
+gtest sharding (GTEST_TOTAL_SHARDS / GTEST_SHARD_INDEX), talks to its own
+gazebo master through GAZEBO_MASTER_URI and is pinned to its own set of
+cores. The per-shard junit files are then merged into a single csv with
+junit_to_csv.rb, matching the output of a serial run.
+"""
+
+from __future__ import print_function
+NAME = "sweep_runner.py"
+
+import argparse
+import os
+import subprocess
+import sys
+
+TOOLS_DIR = os.path.dirname(os.path.abspath(__file__))
+MODELS_DIR = os.path.join(os.path.dirname(TOOLS_DIR), 'models')
+# ports of the concurrent worlds of each shard, at most one world per port
+WORLD_PORTS_PER_SHARD = 100
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(prog=NAME, description=__doc__,
+        usage='%(prog)s [options] binary csv_prefix [-- gtest args]',
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('binary', help='benchmark executable to run')
+    parser.add_argument('csv_prefix',
+        help='prefix for the merged csv file, passed to junit_to_csv.rb')
+    parser.add_argument('-j', '--jobs', type=int, default=0,
+        help='number of worker processes (default: one per core group)')
+    parser.add_argument('--cpus-per-job', type=int, default=1,
+        help='number of cores pinned to each worker (default: 1)')
+    parser.add_argument('--base-port', type=int, default=11345,
+        help='gazebo master port of the first worker (default: 11345)')
+    parser.add_argument('--output-dir', default=None,
+        help='folder for per-shard junit and log files '
+             '(default: test_results next to the binary)')
+    # arguments after -- are passed through to the benchmark binary
+    argv = sys.argv[1:]
+    gtest_args = []
+    if '--' in argv:
+        gtest_args = argv[argv.index('--') + 1:]
+        argv = argv[:argv.index('--')]
+    args = parser.parse_args(argv)
+    args.gtest_args = gtest_args
+    return args
+
+
+def core_groups(jobs, cpus_per_job):
+    """Split the cores available to this process into groups."""
+    cpus = sorted(os.sched_getaffinity(0))
+    if cpus_per_job < 1:
+        sys.exit("%s: --cpus-per-job must be at least 1" % NAME)
+    if cpus_per_job > len(cpus):
+        print("Warning: %d cpus per job requested but only %d available, "
+              "using %d" % (cpus_per_job, len(cpus), len(cpus)),
+              file=sys.stderr)
+        cpus_per_job = len(cpus)
+    groups = [cpus[i:i + cpus_per_job]
+              for i in range(0, len(cpus) - cpus_per_job + 1, cpus_per_job)]
+    if jobs <= 0:
+        jobs = len(groups)
+    if jobs > len(groups):
+        print("Warning: %d workers requested but only %d core groups, "
+              "cores will be shared" % (jobs, len(groups)), file=sys.stderr)
+    return [groups[i % len(groups)] for i in range(jobs)]
+
+
+def start_shard(args, index, count, cpus, output_dir, binary_name):
+    xml = os.path.join(output_dir, '%s_shard%d.xml' % (binary_name, index))
+    log = os.path.join(output_dir, '%s_shard%d.log' % (binary_name, index))
+    # remove stale results so check_test_ran.py notices crashed shards
+    if os.path.exists(xml):
+        os.remove(xml)
+
+    env = dict(os.environ)
+    env['GTEST_TOTAL_SHARDS'] = str(count)
+    env['GTEST_SHARD_INDEX'] = str(index)
+    env['GAZEBO_MASTER_URI'] = 'http://localhost:%d' % (args.base_port + index)
+    env['GAZEBO_MODEL_PATH'] = MODELS_DIR + ':' + env.get('GAZEBO_MODEL_PATH', '')
+    env['BENCHMARK_RESULTS_FILE'] = os.path.join(
+        output_dir, '%s_shard%d.results' % (binary_name, index))
+    # one telemetry port per shard, counting up from the given port
+    if int(os.environ.get('BENCHMARK_TELEMETRY_PORT', '0')) > 0:
+        env['BENCHMARK_TELEMETRY_PORT'] = str(
+            int(os.environ['BENCHMARK_TELEMETRY_PORT']) + index)
+    # one block of world ports per shard for BENCHMARK_concurrent_worlds
+    env['BENCHMARK_WORLD_BASE_PORT'] = str(
+        int(os.environ.get('BENCHMARK_WORLD_BASE_PORT', '12345'))
+        + WORLD_PORTS_PER_SHARD * index)
+    # with several cores per worker, keep physics on the first core
+    # and the gzserver transport threads on the others
+    if len(cpus) > 1:
+        env.setdefault('BENCHMARK_PHYSICS_CPUS', str(cpus[0]))
+        env.setdefault('BENCHMARK_TRANSPORT_CPUS',
+                       ','.join(str(c) for c in cpus[1:]))
+
+    cmd = [os.path.abspath(args.binary), '--gtest_output=xml:' + xml]
+    cmd += args.gtest_args
+    print("Starting shard %d/%d on cpus %s: %s"
+          % (index, count, cpus, ' '.join(cmd)))
+    logfile = open(log, 'w')
+    proc = subprocess.Popen(cmd, env=env, stdout=logfile,
+        stderr=subprocess.STDOUT,
+        preexec_fn=lambda: os.sched_setaffinity(0, cpus))
+    return proc, logfile, xml
+
+
+def main():
+    args = parse_args()
+    binary_name = os.path.basename(args.binary)
+    output_dir = args.output_dir or os.path.join(
+        os.path.dirname(os.path.abspath(args.binary)), 'test_results')
+    if not os.path.exists(output_dir):
+        os.makedirs(output_dir)
+
+    groups = core_groups(args.jobs, args.cpus_per_job)
+    shards = [start_shard(args, i, len(groups), cpus, output_dir, binary_name)
+              for i, cpus in enumerate(groups)]
+
+    failed = 0
+    xmls = []
+    for index, (proc, logfile, xml) in enumerate(shards):
+        result = proc.wait()
+        logfile.close()
+        if result != 0:
+            print("Shard %d exited with code %d, see %s"
+                  % (index, result, logfile.name), file=sys.stderr)
+            failed += 1
+        # write a failure result for shards that crashed before writing xml
+        subprocess.call([sys.executable,
+                         os.path.join(TOOLS_DIR, 'check_test_ran.py'), xml])
+        xmls.append(xml)
+
+    subprocess.check_call([os.path.join(TOOLS_DIR, 'junit_to_csv.rb')]
+                          + xmls + [args.csv_prefix])
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
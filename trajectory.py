@@ -0,0 +1,33 @@
+import struct
+import numpy as np
+
+# Load a binary trajectory file written by TrajectoryWriter.
+# Columns are memory-mapped, not read, so large files load instantly.
+# Returns (params, columns), where params is a dictionary of the test
+# parameters stored in the header and columns maps each column name
+# to a read-only numpy array.
+def loadTrajectory(filename):
+    with open(filename, 'rb') as f:
+        fixed = f.read(40)
+        magic = fixed[0:8]
+        if magic != b'GZBTRAJ1':
+            raise ValueError('%s is not a trajectory file' % filename)
+        version, headerSize, capacity, rowCount, columnCount = \
+            struct.unpack('<IIQQI', fixed[8:36])
+        f.seek(0)
+        header = f.read(headerSize)
+    nameSize = 32
+    maxColumns = 32
+    names = [header[40 + i*nameSize:40 + (i+1)*nameSize].split(b'\0')[0].decode()
+             for i in range(columnCount)]
+    paramsOffset = 40 + maxColumns*nameSize
+    params = {}
+    for line in header[paramsOffset:].split(b'\0')[0].decode().splitlines():
+        key, _, value = line.partition('=')
+        params[key] = value
+    data = np.memmap(filename, dtype='<f8', mode='r', offset=headerSize,
+                     shape=(columnCount, capacity))
+    columns = {}
+    for i, name in enumerate(names):
+        columns[name] = data[i, :rowCount]
+    return params, columns
@@ -0,0 +1,223 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include "trajectory_writer.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+const int TrajectoryWriter::kMaxColumns;
+const int TrajectoryWriter::kNameSize;
+const int TrajectoryWriter::kHeaderSize;
+
+// Number of rows the writer thread gathers before writing,
+// and number of rows the ring buffer can hold.
+static const uint64_t kBatchRows = 4096;
+static const uint64_t kQueueRows = 4 * kBatchRows;
+
+// Header field offsets
+static const off_t kRowCountOffset = 24;
+static const off_t kNamesOffset = 40;
+
+/////////////////////////////////////////////////
+// Write all of _size bytes at _offset.
+static bool WriteAll(int _fd, const void *_data, size_t _size, off_t _offset)
+{
+  const char *data = static_cast<const char *>(_data);
+  while (_size > 0)
+  {
+    const ssize_t n = pwrite(_fd, data, _size, _offset);
+    if (n <= 0)
+      return false;
+    data += n;
+    _size -= n;
+    _offset += n;
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+TrajectoryWriter::TrajectoryWriter()
+{
+}
+
+/////////////////////////////////////////////////
+TrajectoryWriter::~TrajectoryWriter()
+{
+  this->Close();
+}
+
+/////////////////////////////////////////////////
+bool TrajectoryWriter::Open(const std::string &_filename,
+    const std::vector<std::string> &_columns, uint64_t _rows,
+    const std::map<std::string, std::string> &_params)
+{
+  this->Close();
+  if (_columns.empty() || _columns.size() > kMaxColumns)
+  {
+    std::cerr << "Invalid trajectory column count " << _columns.size()
+              << std::endl;
+    return false;
+  }
+
+  // Fixed size header
+  std::vector<char> header(kHeaderSize, 0);
+  const uint32_t version = 1;
+  const uint32_t headerSize = kHeaderSize;
+  const uint64_t rowCount = 0;
+  const uint32_t columnCount = _columns.size();
+  std::memcpy(&header[0], "GZBTRAJ1", 8);
+  std::memcpy(&header[8], &version, sizeof(version));
+  std::memcpy(&header[12], &headerSize, sizeof(headerSize));
+  std::memcpy(&header[16], &_rows, sizeof(_rows));
+  std::memcpy(&header[kRowCountOffset], &rowCount, sizeof(rowCount));
+  std::memcpy(&header[32], &columnCount, sizeof(columnCount));
+  for (size_t c = 0; c < _columns.size(); ++c)
+  {
+    _columns[c].copy(&header[kNamesOffset + c * kNameSize], kNameSize - 1);
+  }
+  std::ostringstream params;
+  for (const auto &param : _params)
+    params << param.first << "=" << param.second << "\n";
+  const size_t paramsOffset = kNamesOffset + kMaxColumns * kNameSize;
+  params.str().copy(&header[paramsOffset], kHeaderSize - paramsOffset - 1);
+
+  this->fd = open(_filename.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  if (this->fd < 0)
+  {
+    std::cerr << "Unable to open trajectory file " << _filename << std::endl;
+    return false;
+  }
+  const off_t size = kHeaderSize + _columns.size() * _rows * sizeof(double);
+  if (ftruncate(this->fd, size) != 0 ||
+      !WriteAll(this->fd, header.data(), header.size(), 0))
+  {
+    std::cerr << "Unable to write trajectory file " << _filename << std::endl;
+    close(this->fd);
+    this->fd = -1;
+    return false;
+  }
+
+  this->columnCount = _columns.size();
+  this->capacity = _rows;
+  this->written = 0;
+  this->stalls = 0;
+  this->failed = false;
+  this->done = false;
+  this->queue.reset(new SpscQueue<Row>(kQueueRows));
+  this->columnBuffers.assign(this->columnCount,
+      std::vector<double>(kBatchRows));
+  this->thread = std::thread(&TrajectoryWriter::Run, this);
+  return true;
+}
+
+/////////////////////////////////////////////////
+void TrajectoryWriter::Write(const Row &_row)
+{
+  while (!this->queue->Push(_row))
+  {
+    ++this->stalls;
+    std::this_thread::yield();
+  }
+}
+
+/////////////////////////////////////////////////
+bool TrajectoryWriter::Close()
+{
+  if (this->fd < 0)
+    return false;
+
+  this->done = true;
+  this->thread.join();
+
+  if (!WriteAll(this->fd, &this->written, sizeof(this->written),
+                kRowCountOffset))
+  {
+    this->failed = true;
+  }
+  close(this->fd);
+  this->fd = -1;
+  this->queue.reset();
+  this->columnBuffers.clear();
+  return !this->failed;
+}
+
+/////////////////////////////////////////////////
+bool TrajectoryWriter::IsOpen() const
+{
+  return this->fd >= 0;
+}
+
+/////////////////////////////////////////////////
+uint64_t TrajectoryWriter::Stalls() const
+{
+  return this->stalls;
+}
+
+/////////////////////////////////////////////////
+void TrajectoryWriter::Run()
+{
+  Row row;
+  while (true)
+  {
+    // read done before draining the queue so no rows pushed
+    // before Close are missed
+    const bool finished = this->done;
+    uint64_t count = 0;
+    while (count < kBatchRows && this->queue->Pop(row))
+    {
+      for (int c = 0; c < this->columnCount; ++c)
+        this->columnBuffers[c][count] = row[c];
+      ++count;
+    }
+
+    if (count > 0)
+      this->Flush(count);
+    else if (finished)
+      break;
+    else
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+/////////////////////////////////////////////////
+void TrajectoryWriter::Flush(uint64_t _count)
+{
+  if (this->written + _count > this->capacity)
+    _count = this->capacity - this->written;
+  if (_count == 0)
+    return;
+
+  for (int c = 0; c < this->columnCount; ++c)
+  {
+    const off_t offset = kHeaderSize +
+        (c * this->capacity + this->written) * sizeof(double);
+    if (!WriteAll(this->fd, this->columnBuffers[c].data(),
+                  _count * sizeof(double), offset))
+    {
+      this->failed = true;
+    }
+  }
+  this->written += _count;
+}
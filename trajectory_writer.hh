@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_TRAJECTORY_WRITER_HH_
+#define BENCHMARK_GAZEBO_TRAJECTORY_WRITER_HH_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "spsc_queue.hh"
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Streams per-step samples to a memory-mappable binary file
+    /// from a background thread.
+    ///
+    /// File layout (little endian):
+    ///   0: magic "GZBTRAJ1"
+    ///   8: uint32 format version (1)
+    ///  12: uint32 header size in bytes (kHeaderSize)
+    ///  16: uint64 row capacity
+    ///  24: uint64 number of rows written
+    ///  32: uint32 number of columns
+    ///  40: column names, kNameSize bytes each, NUL padded
+    ///  after the names: "key=value" lines with the test parameters
+    /// kHeaderSize: one float64 block per column, row capacity long.
+    ///
+    /// trajectory.py loads the columns with numpy.memmap.
+    class TrajectoryWriter
+    {
+      /// \brief Maximum number of columns.
+      public: static const int kMaxColumns = 32;
+
+      /// \brief Size of each column name in the header.
+      public: static const int kNameSize = 32;
+
+      /// \brief Size of the header, a multiple of the page size.
+      public: static const int kHeaderSize = 4096;
+
+      /// \brief One sample, only the first column count values are used.
+      public: typedef std::array<double, kMaxColumns> Row;
+
+      /// \brief Constructor.
+      public: TrajectoryWriter();
+
+      /// \brief Destructor, closes the file if open.
+      public: ~TrajectoryWriter();
+
+      /// \brief Create the file and start the writer thread.
+      /// All buffers are allocated here.
+      /// \param[in] _filename Output file.
+      /// \param[in] _columns Column names.
+      /// \param[in] _rows Maximum number of rows; extra rows are dropped.
+      /// \param[in] _params Test parameters stored in the header.
+      /// \return True if the file was created.
+      public: bool Open(const std::string &_filename,
+                        const std::vector<std::string> &_columns,
+                        uint64_t _rows,
+                        const std::map<std::string, std::string> &_params);
+
+      /// \brief Queue a row for writing. This only copies the row into a
+      /// ring buffer; it waits only if the writer thread falls behind.
+      /// \param[in] _row Sample values, in the order of the columns.
+      public: void Write(const Row &_row);
+
+      /// \brief Flush queued rows, stop the writer thread and
+      /// write the final row count.
+      /// \return True if all rows were written successfully.
+      public: bool Close();
+
+      /// \brief True between a successful Open and Close.
+      public: bool IsOpen() const;
+
+      /// \brief Number of times Write had to wait for the writer thread.
+      public: uint64_t Stalls() const;
+
+      /// \brief Writer thread main loop.
+      private: void Run();
+
+      /// \brief Write rows gathered in the column buffers to the file.
+      /// \param[in] _count Number of gathered rows.
+      private: void Flush(uint64_t _count);
+
+      /// \brief File descriptor, -1 when closed.
+      private: int fd = -1;
+
+      /// \brief Number of columns.
+      private: int columnCount = 0;
+
+      /// \brief Row capacity of the file.
+      private: uint64_t capacity = 0;
+
+      /// \brief Rows written to the file.
+      private: uint64_t written = 0;
+
+      /// \brief Number of waits in Write.
+      private: uint64_t stalls = 0;
+
+      /// \brief True if a write to the file failed.
+      private: bool failed = false;
+
+      /// \brief Set by Close to stop the writer thread.
+      private: std::atomic<bool> done{false};
+
+      /// \brief Rows waiting for the writer thread.
+      private: std::unique_ptr<SpscQueue<Row>> queue;
+
+      /// \brief Per-column staging buffers used by the writer thread.
+      private: std::vector<std::vector<double>> columnBuffers;
+
+      /// \brief Writer thread.
+      private: std::thread thread;
+    };
+  }
+}
+#endif
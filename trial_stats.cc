@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <algorithm>
+#include <cmath>
+
+#include "trial_stats.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+void TrialStats::Insert(double _value)
+{
+  if (this->count == 0)
+  {
+    this->min = _value;
+    this->max = _value;
+  }
+  else
+  {
+    this->min = std::min(this->min, _value);
+    this->max = std::max(this->max, _value);
+  }
+  ++this->count;
+  const double delta = _value - this->mean;
+  this->mean += delta / this->count;
+  this->m2 += delta * (_value - this->mean);
+}
+
+/////////////////////////////////////////////////
+unsigned int TrialStats::Count() const
+{
+  return this->count;
+}
+
+/////////////////////////////////////////////////
+double TrialStats::Mean() const
+{
+  return this->mean;
+}
+
+/////////////////////////////////////////////////
+double TrialStats::StdDev() const
+{
+  if (this->count < 2)
+    return 0.0;
+  return std::sqrt(this->m2 / (this->count - 1));
+}
+
+/////////////////////////////////////////////////
+double TrialStats::Min() const
+{
+  return this->min;
+}
+
+/////////////////////////////////////////////////
+double TrialStats::Max() const
+{
+  return this->max;
+}
+
+/////////////////////////////////////////////////
+double TrialStats::ConfidenceInterval95() const
+{
+  if (this->count < 2)
+    return 0.0;
+
+  // two-sided 95% quantiles of the t distribution for 1-30 degrees
+  // of freedom, normal approximation beyond that
+  static const double t95[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+  const unsigned int dof = this->count - 1;
+  const double t = dof <= 30 ? t95[dof - 1] : 1.960;
+  return t * this->StdDev() / std::sqrt(static_cast<double>(this->count));
+}
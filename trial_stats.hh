@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_TRIAL_STATS_HH_
+#define BENCHMARK_GAZEBO_TRIAL_STATS_HH_
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Summary statistics of a measurement repeated over
+    /// several trials, such as wall time.
+    class TrialStats
+    {
+      /// \brief Add the result of one trial.
+      /// \param[in] _value Measured value.
+      public: void Insert(double _value);
+
+      /// \brief Number of trials.
+      public: unsigned int Count() const;
+
+      /// \brief Sample mean.
+      public: double Mean() const;
+
+      /// \brief Sample standard deviation, 0 for fewer than 2 trials.
+      public: double StdDev() const;
+
+      /// \brief Smallest value.
+      public: double Min() const;
+
+      /// \brief Largest value.
+      public: double Max() const;
+
+      /// \brief Half-width of the 95% confidence interval of the mean,
+      /// using the Student t distribution.
+      public: double ConfidenceInterval95() const;
+
+      /// \brief Number of trials.
+      private: unsigned int count = 0;
+
+      /// \brief Running mean (Welford's algorithm).
+      private: double mean = 0.0;
+
+      /// \brief Running sum of squared differences from the mean.
+      private: double m2 = 0.0;
+
+      /// \brief Smallest value.
+      private: double min = 0.0;
+
+      /// \brief Largest value.
+      private: double max = 0.0;
+    };
+  }
+}
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <cmath>
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <ignition/math/SignalStats.hh>
+#include <ignition/math/Vector3.hh>
+
+#include "gazebo/physics/physics.hh"
+#include "step_timer.hh"
+#include "triball.hh"
+#include "world_builder.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+// TriballDrift:
+// Place a triball on a slope with enough friction to hold it and record
+// how far it drifts
+void TriballFixture::TriballDrift(const std::string &_physicsEngine
+                                , double _dt
+                                , const std::string &_model)
+{
+  // Same slope as triball_drift.world, one model per world so that
+  // the step time is attributed to a single representation.
+  WorldBuilder builder;
+  builder.SetGravity(ignition::math::Vector3d(1, 0, -9.8));
+  builder.AddInclude("model://ground_plane");
+  builder.AddInclude("model://" + _model);
+  const std::string worldFile = builder.WriteTemporary("triball");
+  ASSERT_FALSE(worldFile.empty());
+  physics::WorldPtr world;
+  this->LoadPhysicsWorld(worldFile, _physicsEngine, world);
+  boost::filesystem::remove(worldFile);
+  if (this->HasFatalFailure())
+    return;
+  physics::PhysicsEnginePtr physics = world->Physics();
+
+  physics::ModelPtr model = world->ModelByName(_model);
+  ASSERT_NE(model, nullptr);
+  const physics::Link_V &links = model->GetLinks();
+  ASSERT_FALSE(links.empty());
+  this->Record("linkCount", links.size());
+  this->Record("jointCount", model->GetJointCount());
+
+  // initial position of the model and its total energy
+  const ignition::math::Vector3d p0 = model->WorldPose().Pos();
+  double E0 = 0.0;
+  for (const auto &link : links)
+    E0 += link->GetWorldEnergy();
+
+  physics->SetMaxStepSize(_dt);
+  const double simDuration = 10.0;
+  const int steps = ceil(simDuration / _dt);
+
+  // variables to compute statistics on
+  ignition::math::SignalStats driftPosition;
+  ignition::math::SignalStats driftSpeed;
+  {
+    const std::string statNames = "maxAbs";
+    EXPECT_TRUE(driftPosition.InsertStatistics(statNames));
+    EXPECT_TRUE(driftSpeed.InsertStatistics(statNames));
+  }
+
+  // unthrottle update rate
+  physics->SetRealTimeUpdateRate(0.0);
+  StepTimer stepTimer;
+  const common::Time t0 = world->SimTime();
+  const common::Time startTime = common::Time::GetWallTime();
+  for (int i = 0; i < steps; ++i)
+  {
+    stepTimer.Start();
+    this->StepWorld(world, 1);
+    stepTimer.Stop();
+
+    // horizontal displacement and speed of the model
+    ignition::math::Vector3d displacement = model->WorldPose().Pos() - p0;
+    ignition::math::Vector3d velocity = model->WorldLinearVel();
+    displacement.Z(0.0);
+    velocity.Z(0.0);
+    driftPosition.InsertData(displacement.Length());
+    driftSpeed.InsertData(velocity.Length());
+  }
+  const common::Time elapsedTime = common::Time::GetWallTime() - startTime;
+  const common::Time simTime = world->SimTime() - t0;
+  ASSERT_NEAR(simTime.Double(), simDuration, _dt*1.1);
+
+  this->RecordStepTimes(stepTimer, elapsedTime, simTime);
+  this->Record("linkStepsPerSecond", static_cast<double>(links.size()) *
+      stepTimer.Count() / stepTimer.Total());
+
+  // Final drift distance and its average rate, and the energy lost
+  // to contact, which should stay near zero for a triball at rest
+  ignition::math::Vector3d displacement = model->WorldPose().Pos() - p0;
+  displacement.Z(0.0);
+  double E = 0.0;
+  for (const auto &link : links)
+    E += link->GetWorldEnergy();
+  this->Record("drift", displacement.Length());
+  this->Record("driftRate", displacement.Length() / simTime.Double());
+  this->Record("driftPosition_", driftPosition);
+  this->Record("driftSpeed_", driftSpeed);
+  this->Record("energy0", E0);
+  this->Record("energyChange", E - E0);
+}
+
+/////////////////////////////////////////////////
+TEST_P(TriballDriftTest, TriballDrift)
+{
+  std::string physicsEngine = std::tr1::get<0>(GetParam());
+  double dt                 = std::tr1::get<1>(GetParam());
+  std::string modelName     = std::tr1::get<2>(GetParam());
+  gzdbg << physicsEngine
+        << ", dt: " << dt
+        << ", model: " << modelName
+        << std::endl;
+  RecordProperty("engine", physicsEngine);
+  this->Record("dt", dt);
+  RecordProperty("model", modelName);
+  TriballDrift(physicsEngine
+             , dt
+             , modelName);
+}
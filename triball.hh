@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#ifndef BENCHMARK_GAZEBO_TRIBALL_HH_
+#define BENCHMARK_GAZEBO_TRIBALL_HH_
+
+#include <string>
+#include "benchmark_fixture.hh"
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Fixture for a triball resting on a slope, represented
+    /// with gravity tilted from the ground normal, as in
+    /// worlds/triball_drift.world. Friction should hold the triball
+    /// still, so any motion is drift.
+    class TriballFixture : public BenchmarkFixture
+    {
+      /// \brief Load a triball model on a ground plane with tilted
+      /// gravity, step it and record the step time and drift.
+      /// \param[in] _physicsEngine Physics engine to use.
+      /// \param[in] _dt Max time step size.
+      /// \param[in] _model Name of the triball model, such as
+      /// triball_lumped (one link), triball_fixed (fixed joints)
+      /// or triball_revolute (revolute joints).
+      public: void TriballDrift(const std::string &_physicsEngine
+                              , double _dt
+                              , const std::string &_model);
+    };
+
+    // physics engine
+    // dt
+    // triball model
+    typedef std::tr1::tuple < const char *
+                            , double
+                            , const char *
+                            > char1double1char1;
+    class TriballDriftTest : public TriballFixture,
+        public testing::WithParamInterface<char1double1char1>
+    {
+    };
+  }
+}
+#endif
@@ -0,0 +1,371 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <string>
+
+#include <boost/filesystem.hpp>
+#include <sdf/sdf.hh>
+
+#include "gazebo/common/Console.hh"
+#include "gazebo/physics/physics.hh"
+#include "world_builder.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+WorldBuilder::WorldBuilder(const std::string &_worldName)
+  : worldName(_worldName)
+{
+}
+
+/////////////////////////////////////////////////
+void WorldBuilder::SetGravity(const ignition::math::Vector3d &_gravity)
+{
+  std::ostringstream stream;
+  stream << "<gravity>" << _gravity << "</gravity>\n";
+  this->gravity = stream.str();
+}
+
+/////////////////////////////////////////////////
+void WorldBuilder::SetPhysicsEngine(const std::string &_physicsEngine)
+{
+  this->physics = "<physics type='" + _physicsEngine + "'/>\n";
+}
+
+/////////////////////////////////////////////////
+void WorldBuilder::AddInclude(const std::string &_uri,
+    const ignition::math::Pose3d &_pose,
+    const std::string &_name)
+{
+  this->body << "<include>\n"
+             << "  <uri>" << _uri << "</uri>\n"
+             << "  <pose>" << _pose << "</pose>\n";
+  if (!_name.empty())
+    this->body << "  <name>" << _name << "</name>\n";
+  this->body << "</include>\n";
+  ++this->modelCount;
+}
+
+/////////////////////////////////////////////////
+void WorldBuilder::AddModel(const msgs::Model &_model)
+{
+  this->body << msgs::ModelToSDF(_model)->ToString("");
+  ++this->modelCount;
+}
+
+/////////////////////////////////////////////////
+void WorldBuilder::AddModels(const std::vector<msgs::Model> &_models)
+{
+  for (const auto &msg : _models)
+    this->AddModel(msg);
+}
+
+/////////////////////////////////////////////////
+void WorldBuilder::AddSdf(const std::string &_sdf, size_t _modelCount)
+{
+  this->body << _sdf;
+  this->modelCount += _modelCount;
+}
+
+/////////////////////////////////////////////////
+size_t WorldBuilder::ModelCount() const
+{
+  return this->modelCount;
+}
+
+/////////////////////////////////////////////////
+std::string WorldBuilder::ToString() const
+{
+  std::ostringstream out;
+  out << "<?xml version='1.0' ?>\n"
+      << "<sdf version='" << SDF_VERSION << "'>\n"
+      << "<world name='" << this->worldName << "'>\n"
+      << this->gravity
+      << this->physics
+      << this->body.str()
+      << "</world>\n"
+      << "</sdf>\n";
+  return out.str();
+}
+
+/////////////////////////////////////////////////
+std::string WorldBuilder::WriteTemporary(const std::string &_prefix) const
+{
+  const boost::filesystem::path path =
+      boost::filesystem::temp_directory_path() /
+      boost::filesystem::unique_path(_prefix + "_%%%%-%%%%-%%%%.world");
+  std::ofstream out(path.string());
+  if (!out)
+  {
+    gzerr << "Unable to write world file " << path << std::endl;
+    return std::string();
+  }
+  out << this->ToString();
+  if (!out)
+  {
+    gzerr << "Unable to write world file " << path << std::endl;
+    return std::string();
+  }
+  return path.string();
+}
+
+/////////////////////////////////////////////////
+std::vector<ignition::math::Vector3d> gazebo::benchmark::LatticePositions(
+    int _count, double _pitch)
+{
+  std::vector<ignition::math::Vector3d> positions;
+  if (_count <= 0)
+    return positions;
+  const int edge = std::ceil(std::cbrt(_count) - 1e-9);
+  positions.reserve(_count);
+  for (int i = 0; i < _count; ++i)
+  {
+    positions.emplace_back(_pitch * (i % edge),
+                           _pitch * ((i / edge) % edge),
+                           _pitch * (i / (edge * edge)));
+  }
+  return positions;
+}
+
+/////////////////////////////////////////////////
+std::vector<msgs::Model> gazebo::benchmark::BoxLattice(
+    const msgs::Model &_box, int _count, double _pitch,
+    const std::string &_prefix)
+{
+  std::vector<msgs::Model> models;
+  int i = 0;
+  for (const auto &position : LatticePositions(_count, _pitch))
+  {
+    msgs::Model msgModel = _box;
+    msgModel.set_name(_prefix + std::to_string(i++));
+    msgs::Set(msgModel.mutable_pose(),
+              ignition::math::Pose3d(position, ignition::math::Quaterniond()));
+    models.push_back(msgModel);
+  }
+  return models;
+}
+
+/////////////////////////////////////////////////
+std::vector<msgs::Model> gazebo::benchmark::SpherePairGrid(int _pairCount)
+{
+  const double density = 600;
+  const std::vector<std::string> ratios =
+    {"30", "25", "22", "21", "20", "19", "18", "15", "10", "05", "01", "00"};
+  const int pairsPerCopy = 2 * ratios.size();
+
+  std::vector<msgs::Model> models;
+  for (int i = 0; i < _pairCount; ++i)
+  {
+    const int index = i % pairsPerCopy;
+    const int copy = i / pairsPerCopy;
+    const bool mm = index < pairsPerCopy / 2;
+    const double radius = mm ? 1e-3 : 1e-1;
+    const std::string &ratio = ratios[index % ratios.size()];
+    const double separation = std::stod(ratio) / 10 * radius;
+    const double mass = density * 4.0 / 3.0 * M_PI * std::pow(radius, 3);
+    for (const char suffix : {'A', 'B'})
+    {
+      msgs::Model msgModel;
+      msgModel.set_name((mm ? "mm" : "dm") + ratio + suffix
+                        + "_" + std::to_string(copy));
+      msgs::AddSphereLink(msgModel, mass, radius);
+      msgs::Set(msgModel.mutable_pose(), ignition::math::Pose3d(
+          copy * 1.0 + (suffix == 'B' ? separation : 0.0),
+          index * 0.3, 0.5, 0, 0, 0));
+      models.push_back(msgModel);
+    }
+  }
+  return models;
+}
+
+/////////////////////////////////////////////////
+void gazebo::benchmark::AddTriballFan(WorldBuilder &_builder,
+    int _n, double _w0max, const ignition::math::Vector3d &_v0,
+    const std::string &_uri)
+{
+  for (int i = 0; i <= 2 * _n; ++i)
+  {
+    const std::string name = "triball_" + std::to_string(i);
+    const double w0z = _n > 0 ? _w0max * (i - _n) / _n : 0.0;
+    std::ostringstream sdf;
+    sdf << "<model name='" << name << "'>\n"
+        << "  <include>\n"
+        << "    <uri>" << _uri << "</uri>\n"
+        << "    <pose>" << 0.3 * i << " 0 0  0 0 0</pose>\n"
+        << "  </include>\n"
+        << "  <plugin name='" << name << "'"
+        << " filename='libInitialVelocityPlugin.so'>\n"
+        << "    <linear>" << _v0 << "</linear>\n"
+        << "    <angular>0 0 " << w0z << "</angular>\n"
+        << "  </plugin>\n"
+        << "</model>\n";
+    _builder.AddSdf(sdf.str(), 1);
+  }
+}
+
+/////////////////////////////////////////////////
+void gazebo::benchmark::AddRevoluteChain(WorldBuilder &_builder,
+    int _linkCount, bool _tree, double _linkLength, const std::string &_name)
+{
+  const double mass = 0.1;
+  const double width = 0.02;
+  const double ixx = mass / 12.0 * 2 * width * width;
+  const double iyy = mass / 12.0 * (_linkLength * _linkLength + width * width);
+
+  // each link frame is at the joint with its parent, at the far end
+  // of the parent link, and siblings of a tree are spread along y
+  std::vector<ignition::math::Vector3d> origins;
+  std::ostringstream sdf;
+  sdf << "<model name='" << _name << "'>\n";
+  for (int i = 0; i < _linkCount; ++i)
+  {
+    const int parent = i == 0 ? -1 : (_tree ? (i - 1) / 2 : i - 1);
+    ignition::math::Vector3d origin;
+    if (parent >= 0)
+    {
+      origin = origins[parent] + ignition::math::Vector3d(_linkLength, 0, 0);
+      if (_tree)
+      {
+        const int depth = std::floor(std::log2(i + 1));
+        const double spread = 0.5 * _linkLength / (1 << (depth - 1));
+        origin.Y(origin.Y() + ((i % 2) ? -spread : spread));
+      }
+    }
+    origins.push_back(origin);
+
+    const std::string link = "link_" + std::to_string(i);
+    sdf << "  <link name='" << link << "'>\n"
+        << "    <pose>" << origin << " 0 0 0</pose>\n"
+        << "    <inertial>\n"
+        << "      <pose>" << 0.5 * _linkLength << " 0 0  0 0 0</pose>\n"
+        << "      <mass>" << mass << "</mass>\n"
+        << "      <inertia>\n"
+        << "        <ixx>" << ixx << "</ixx>\n"
+        << "        <iyy>" << iyy << "</iyy>\n"
+        << "        <izz>" << iyy << "</izz>\n"
+        << "        <ixy>0</ixy><ixz>0</ixz><iyz>0</iyz>\n"
+        << "      </inertia>\n"
+        << "    </inertial>\n"
+        << "  </link>\n"
+        << "  <joint name='joint_" << i << "' type='revolute'>\n"
+        << "    <parent>"
+        << (parent >= 0 ? "link_" + std::to_string(parent) : "world")
+        << "</parent>\n"
+        << "    <child>" << link << "</child>\n"
+        << "    <axis>\n"
+        << "      <xyz>0 1 0</xyz>\n"
+        << "      <limit><lower>-1e16</lower><upper>1e16</upper></limit>\n"
+        << "    </axis>\n"
+        << "  </joint>\n";
+  }
+  sdf << "</model>\n";
+  _builder.AddSdf(sdf.str(), 1);
+}
+
+/////////////////////////////////////////////////
+// Add the models of a scene named <kind>_<count> to a builder.
+static bool BuildScene(const std::string &_scene,
+    const std::string &_physicsEngine, WorldBuilder &_builder,
+    std::string &_kind)
+{
+  const size_t underscore = _scene.rfind('_');
+  if (underscore == std::string::npos)
+  {
+    gzerr << "Unrecognized scene: " << _scene << std::endl;
+    return false;
+  }
+  _kind = _scene.substr(0, underscore);
+
+  // a positive count, without throwing on names such as boxes_abc
+  const char *countStart = _scene.c_str() + underscore + 1;
+  char *countEnd = nullptr;
+  errno = 0;
+  const long parsed = std::strtol(countStart, &countEnd, 10);
+  if (countEnd == countStart || *countEnd != '\0' || errno == ERANGE ||
+      parsed <= 0 || parsed > std::numeric_limits<int>::max())
+  {
+    gzerr << "Invalid count in scene: " << _scene << std::endl;
+    return false;
+  }
+  const int count = static_cast<int>(parsed);
+
+  if (!_physicsEngine.empty())
+    _builder.SetPhysicsEngine(_physicsEngine);
+  if (_kind == "boxes")
+  {
+    msgs::Model box;
+    msgs::AddBoxLink(box, 10.0, ignition::math::Vector3d(0.1, 0.4, 0.9));
+    _builder.AddModels(BoxLattice(box, count, 1.0));
+  }
+  else if (_kind == "spheres")
+  {
+    _builder.AddModels(SpherePairGrid(count));
+  }
+  else if (_kind == "triball")
+  {
+    _builder.AddInclude("model://ground_plane");
+    AddTriballFan(_builder, count, 150.0, ignition::math::Vector3d(0, 15, 0));
+  }
+  else
+  {
+    gzerr << "Unrecognized scene: " << _scene << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/////////////////////////////////////////////////
+std::string gazebo::benchmark::SceneSdf(const std::string &_scene,
+    const std::string &_physicsEngine)
+{
+  WorldBuilder builder;
+  std::string kind;
+  if (!BuildScene(_scene, _physicsEngine, builder, kind))
+    return std::string();
+  return builder.ToString();
+}
+
+/////////////////////////////////////////////////
+std::string gazebo::benchmark::WriteScene(const std::string &_scene,
+    const std::string &_physicsEngine)
+{
+  WorldBuilder builder;
+  std::string kind;
+  if (!BuildScene(_scene, _physicsEngine, builder, kind))
+    return std::string();
+  return builder.WriteTemporary(kind);
+}
+
+/////////////////////////////////////////////////
+physics::WorldPtr gazebo::benchmark::LoadWorldSdf(const std::string &_sdf)
+{
+  sdf::SDFPtr sdf(new sdf::SDF);
+  if (!sdf::init(sdf) || !sdf::readString(_sdf, sdf))
+  {
+    gzerr << "Unable to parse world sdf" << std::endl;
+    return physics::WorldPtr();
+  }
+  physics::WorldPtr world = physics::create_world();
+  physics::load_world(world, sdf->Root()->GetElement("world"));
+  physics::init_world(world);
+  return world;
+}
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_WORLD_BUILDER_HH_
+#define BENCHMARK_GAZEBO_WORLD_BUILDER_HH_
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Vector3.hh>
+
+#include "gazebo/msgs/msgs.hh"
+#include "gazebo/physics/PhysicsTypes.hh"
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief Builds the sdf of a world in memory, so that fixtures can
+    /// generate large scenes at test time instead of loading worlds
+    /// generated offline from erb templates.
+    class WorldBuilder
+    {
+      /// \brief Constructor.
+      /// \param[in] _worldName Name of the world.
+      public: explicit WorldBuilder(const std::string &_worldName = "default");
+
+      /// \brief Set the gravity of the world.
+      /// \param[in] _gravity Gravity vector.
+      public: void SetGravity(const ignition::math::Vector3d &_gravity);
+
+      /// \brief Set the physics engine of the world, for worlds that are
+      /// loaded without the engine argument of ServerFixture::Load.
+      /// \param[in] _physicsEngine Physics engine type, such as ode.
+      public: void SetPhysicsEngine(const std::string &_physicsEngine);
+
+      /// \brief Include a model by uri, such as model://ground_plane.
+      /// \param[in] _uri Model uri.
+      /// \param[in] _pose Model pose.
+      /// \param[in] _name Model name, or empty to keep the included name.
+      public: void AddInclude(const std::string &_uri,
+                  const ignition::math::Pose3d &_pose =
+                      ignition::math::Pose3d::Zero,
+                  const std::string &_name = "");
+
+      /// \brief Add a model.
+      /// \param[in] _model Model message.
+      public: void AddModel(const msgs::Model &_model);
+
+      /// \brief Add a batch of models.
+      /// \param[in] _models Model messages.
+      public: void AddModels(const std::vector<msgs::Model> &_models);
+
+      /// \brief Add raw sdf elements inside the world element.
+      /// \param[in] _sdf Sdf text.
+      /// \param[in] _modelCount Number of models in the text.
+      public: void AddSdf(const std::string &_sdf, size_t _modelCount = 0);
+
+      /// \brief Number of models and includes added.
+      public: size_t ModelCount() const;
+
+      /// \brief Sdf text of the world.
+      public: std::string ToString() const;
+
+      /// \brief Write the world to a temporary file, for
+      /// ServerFixture::Load. Worlds loaded in the test process can be
+      /// loaded from ToString with LoadWorldSdf instead.
+      /// \param[in] _prefix Prefix of the file name.
+      /// \return Path of the file, or an empty string on failure.
+      public: std::string WriteTemporary(const std::string &_prefix) const;
+
+      /// \brief Name of the world.
+      private: std::string worldName;
+
+      /// \brief Gravity element, empty if not set.
+      private: std::string gravity;
+
+      /// \brief Physics element, empty if not set.
+      private: std::string physics;
+
+      /// \brief Elements inside the world element.
+      private: std::ostringstream body;
+
+      /// \brief Number of models and includes added.
+      private: size_t modelCount = 0;
+    };
+
+    /// \brief Positions on a cubic lattice, filled along x, then y, then z,
+    /// with ceil(cbrt(_count)) positions along each edge.
+    /// \param[in] _count Number of positions.
+    /// \param[in] _pitch Distance between neighboring positions.
+    /// \return Lattice positions.
+    std::vector<ignition::math::Vector3d> LatticePositions(int _count,
+                                                           double _pitch);
+
+    /// \brief Copies of a box model on a cubic lattice.
+    /// \param[in] _box Model to copy.
+    /// \param[in] _count Number of copies.
+    /// \param[in] _pitch Distance between neighboring boxes.
+    /// \param[in] _prefix Prefix of model names, followed by the index.
+    /// \return Model messages.
+    std::vector<msgs::Model> BoxLattice(const msgs::Model &_box,
+                                        int _count,
+                                        double _pitch,
+                                        const std::string &_prefix = "box_");
+
+    /// \brief Pairs of spheres with the radii and separations of
+    /// collide_spheres.world.erb, named like mm19A_0 and mm19B_0.
+    /// Every 24 pairs form a copy of that world, offset by 1m along x.
+    /// \param[in] _pairCount Number of sphere pairs.
+    /// \return Model messages.
+    std::vector<msgs::Model> SpherePairGrid(int _pairCount);
+
+    /// \brief Add 2N+1 included models spaced 0.3m apart along x, as in
+    /// triball.world.erb, with initial linear velocity _v0 and initial
+    /// angular velocity about z evenly spaced in [-_w0max, _w0max],
+    /// set with the InitialVelocityPlugin.
+    /// \param[in] _builder World to add the models to.
+    /// \param[in] _n Number of models on each side of zero velocity.
+    /// \param[in] _w0max Largest magnitude of initial angular velocity.
+    /// \param[in] _v0 Initial linear velocity.
+    /// \param[in] _uri Uri of the included model.
+    void AddTriballFan(WorldBuilder &_builder,
+                       int _n,
+                       double _w0max,
+                       const ignition::math::Vector3d &_v0,
+                       const std::string &_uri = "model://triball");
+
+    /// \brief Sdf of a generated scene named <kind>_<count>:
+    /// boxes_<count> (colliding boxes on a lattice, without ground),
+    /// spheres_<pairs> (SpherePairGrid) or triball_<N> (2N+1 triballs on a
+    /// ground plane, see AddTriballFan).
+    /// \param[in] _scene Scene name.
+    /// \param[in] _physicsEngine Physics engine set in the world, or empty
+    /// for worlds loaded with the engine argument of ServerFixture::Load.
+    /// \return World sdf, or an empty string if the name is not
+    /// recognized or its count is not a positive integer.
+    std::string SceneSdf(const std::string &_scene,
+                         const std::string &_physicsEngine = "");
+
+    /// \brief Write the scene of SceneSdf to a temporary world file, for
+    /// ServerFixture::Load, which only loads world files.
+    /// \param[in] _scene Scene name.
+    /// \param[in] _physicsEngine Physics engine set in the world, or empty.
+    /// \return Path of the file, or an empty string if the name is not
+    /// recognized or the file cannot be written.
+    std::string WriteScene(const std::string &_scene,
+                           const std::string &_physicsEngine = "");
+
+    /// \brief Load and initialize a world in this process from sdf text,
+    /// such as WorldBuilder::ToString, without a temporary file. The
+    /// in-process server must be set up with gazebo::setupServer.
+    /// \param[in] _sdf World sdf, with the physics engine set.
+    /// \return The loaded world, or nullptr if the sdf does not parse.
+    physics::WorldPtr LoadWorldSdf(const std::string &_sdf);
+
+    /// \brief Add a model of identical box links connected by revolute
+    /// joints about the y axis, without collision shapes, and attached to
+    /// the world by a revolute joint at the model origin. The links start
+    /// horizontal along +x and swing under gravity.
+    /// \param[in] _builder World to add the model to.
+    /// \param[in] _linkCount Number of links, and of joints.
+    /// \param[in] _tree False for a serial chain where link i is the child
+    /// of link i-1, true for a binary tree where link i is the child of
+    /// link (i-1)/2.
+    /// \param[in] _linkLength Length of each link along x.
+    /// \param[in] _name Model name. Links are named link_<i> and joints
+    /// joint_<i>, after their child link.
+    void AddRevoluteChain(WorldBuilder &_builder,
+                          int _linkCount,
+                          bool _tree,
+                          double _linkLength = 0.2,
+                          const std::string &_name = "chain");
+  }
+}
+#endif
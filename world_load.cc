@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include <string.h>
+
+#include "startup.hh"
+#include "gazebo/test/helper_physics_generator.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+// Checked-in worlds and generated scenes of increasing size
+INSTANTIATE_TEST_CASE_P(EnginesWorlds, StartupTest,
+  ::testing::Combine(PHYSICS_ENGINE_VALUES
+  , ::testing::Values("worlds/collide_spheres.world"
+                    , "worlds/triball_drift.world"
+                    , "worlds/boxes_5_complex.world"
+                    , "boxes_1000"
+                    , "boxes_10000"
+                    , "spheres_2400"
+                    , "triball_64")));
+
+/////////////////////////////////////////////////
+int main(int argc, char **argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
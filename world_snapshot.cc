@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+#include "gazebo/physics/physics.hh"
+#include "world_snapshot.hh"
+
+using namespace gazebo;
+using namespace benchmark;
+
+/////////////////////////////////////////////////
+void WorldSnapshot::Capture(physics::WorldPtr _world)
+{
+  this->links.clear();
+  this->simTime = _world->SimTime();
+  for (const auto &model : _world->Models())
+  {
+    for (const auto &link : model->GetLinks())
+    {
+      LinkState state;
+      state.link = link;
+      state.pose = link->WorldPose();
+      state.linearVel = link->WorldLinearVel();
+      state.angularVel = link->WorldAngularVel();
+      this->links.push_back(state);
+    }
+  }
+}
+
+/////////////////////////////////////////////////
+bool WorldSnapshot::Restore(physics::WorldPtr _world) const
+{
+  // World::Reset resets time, model poses and the physics engine
+  _world->Reset();
+  _world->SetSimTime(this->simTime);
+
+  size_t linkCount = 0;
+  for (const auto &model : _world->Models())
+    linkCount += model->GetLinks().size();
+
+  for (const auto &state : this->links)
+  {
+    state.link->SetWorldPose(state.pose);
+    state.link->SetLinearVel(state.linearVel);
+    state.link->SetAngularVel(state.angularVel);
+  }
+  return linkCount == this->links.size();
+}
+
+/////////////////////////////////////////////////
+size_t WorldSnapshot::LinkCount() const
+{
+  return this->links.size();
+}
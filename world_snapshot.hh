@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2015 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef BENCHMARK_GAZEBO_WORLD_SNAPSHOT_HH_
+#define BENCHMARK_GAZEBO_WORLD_SNAPSHOT_HH_
+
+#include <vector>
+#include <ignition/math/Pose3.hh>
+#include <ignition/math/Vector3.hh>
+
+#include "gazebo/common/Time.hh"
+#include "gazebo/physics/PhysicsTypes.hh"
+
+namespace gazebo
+{
+  namespace benchmark
+  {
+    /// \brief In-process snapshot of the poses and velocities of every
+    /// link in a world, used to rerun a loaded world from the same state
+    /// instead of reloading it and respawning its models.
+    ///
+    /// Angular velocities are stored as vectors rather than through
+    /// physics::WorldState, which encodes them as Euler angles and
+    /// wraps magnitudes above pi rad/s. Engine solver state (such as
+    /// warm start data and contact caches) is not exposed by gazebo,
+    /// so Restore resets the engine, and every restore starts from
+    /// a cold solver.
+    class WorldSnapshot
+    {
+      /// \brief Capture the state of a world.
+      /// \param[in] _world World to capture.
+      public: void Capture(physics::WorldPtr _world);
+
+      /// \brief Reset the world and engine, then restore the captured
+      /// simulation time, link poses and velocities.
+      /// The world should be paused.
+      /// \param[in] _world World that was captured.
+      /// \return False if the models of the world have changed.
+      public: bool Restore(physics::WorldPtr _world) const;
+
+      /// \brief Number of captured links.
+      public: size_t LinkCount() const;
+
+      /// \brief State of one link.
+      private: struct LinkState
+      {
+        /// \brief Link.
+        physics::LinkPtr link;
+
+        /// \brief World pose.
+        ignition::math::Pose3d pose;
+
+        /// \brief World linear velocity of the link origin, as set by
+        /// Link::SetLinearVel.
+        ignition::math::Vector3d linearVel;
+
+        /// \brief World angular velocity.
+        ignition::math::Vector3d angularVel;
+      };
+
+      /// \brief Captured link states.
+      private: std::vector<LinkState> links;
+
+      /// \brief Captured simulation time.
+      private: common::Time simTime;
+    };
+  }
+}
+#endif